@@ -0,0 +1,174 @@
+/**
+ * @file mrpiz_replay.c
+ * @brief Replay backend of the mrpiz API, linked instead of libintoxmrpiz.a.
+ *
+ * Answers every mrpiz call from a trace recorded with MRPIZ_TRACE (see
+ * mrpiz_trace.h), without the simulator and without waiting. Calls are
+ * matched in order on their identifier and first argument; when the
+ * application diverges from the trace, the replay resynchronizes on the
+ * next matching record within a small window, or answers the last value
+ * recorded for that call.
+ *
+ * Build with : make clean && make BACKEND=replay
+ * Run with   : MRPIZ_REPLAY=run.trace ../bin/go
+ */
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "mrpiz.h"
+#include "../robot_app/mrpiz_trace.h"
+
+/** @brief Number of records searched ahead to resynchronize after a divergence. */
+#define REPLAY_RESYNC_WINDOW 64
+/** @brief Number of distinct first arguments remembered per call. */
+#define REPLAY_ARG_NB 8
+
+static const mrpiz_trace_record_t *records = NULL;  // Mapped trace records
+static size_t record_nb = 0;                        // Number of records in the trace
+static size_t cursor = 0;                           // Next record to answer from
+static void *mapping = NULL;                        // Whole mapped file
+static size_t mapping_size = 0;                     // Size of the mapping
+static int last_ret[MRPIZ_CALL_NB][REPLAY_ARG_NB];  // Last answer per call and argument
+static bool seen[MRPIZ_CALL_NB][REPLAY_ARG_NB];     // true once last_ret is known
+static unsigned long answered = 0;                  // Calls answered from the trace
+static unsigned long divergences = 0;               // Calls that did not match the trace
+static unsigned long skipped = 0;                   // Records skipped to resynchronize
+static unsigned long command_mismatches = 0;        // Motor commands differing from the trace
+static pthread_mutex_t replay_lock = PTHREAD_MUTEX_INITIALIZER; // Control and UI threads
+
+// Maps the trace file named by MRPIZ_REPLAY
+static int replay_load(void) {
+    const char *path = getenv(MRPIZ_REPLAY_ENV);
+    struct stat st;
+    int fd;
+
+    if (path == NULL) {
+        fprintf(stderr, "Rejeu : définir %s avec le fichier de trace.\n", MRPIZ_REPLAY_ENV);
+        return -1;
+    }
+    fd = open(path, O_RDONLY);
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        perror(path);
+        return -1;
+    }
+    mapping_size = (size_t)st.st_size;
+    mapping = mmap(NULL, mapping_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        mapping = NULL;
+        perror(path);
+        return -1;
+    }
+
+    const mrpiz_trace_header_t *header = mapping;
+    if (mapping_size < sizeof(*header) || header->magic != MRPIZ_TRACE_MAGIC ||
+        header->version != MRPIZ_TRACE_VERSION || header->record_size != sizeof(mrpiz_trace_record_t)) {
+        fprintf(stderr, "Rejeu : %s n'est pas une trace mrpiz valide.\n", path);
+        munmap(mapping, mapping_size);
+        mapping = NULL;
+        return -1;
+    }
+    records = (const mrpiz_trace_record_t *)(header + 1);
+    record_nb = (mapping_size - sizeof(*header)) / sizeof(mrpiz_trace_record_t);
+    cursor = 0;
+    return 0;
+}
+
+// Answers one call from the trace (arg1 is only compared for motor commands)
+static int replay_call(mrpiz_call_t call, int arg0, int arg1, int fallback) {
+    int slot = (arg0 >= 0 && arg0 < REPLAY_ARG_NB) ? arg0 : 0;
+    int ret;
+
+    pthread_mutex_lock(&replay_lock);
+    ret = seen[call][slot] ? last_ret[call][slot] : fallback;
+    for (size_t i = cursor; i < record_nb && i < cursor + REPLAY_RESYNC_WINDOW; i++) {
+        if (records[i].call == (int32_t)call && records[i].arg0 == arg0) {
+            skipped += i - cursor;
+            if (i != cursor) {
+                divergences++;
+            }
+            if (call == MRPIZ_CALL_MOTOR_SET && records[i].arg1 != arg1) {
+                command_mismatches++;
+            }
+            cursor = i + 1;
+            answered++;
+            ret = records[i].ret;
+            last_ret[call][slot] = ret;
+            seen[call][slot] = true;
+            pthread_mutex_unlock(&replay_lock);
+            return ret;
+        }
+    }
+    divergences++;
+    pthread_mutex_unlock(&replay_lock);
+    return ret;
+}
+
+int mrpiz_init_intox(const char *address, const int port) {
+    (void)address;
+    (void)port;
+    if (replay_load() != 0) {
+        return -1;
+    }
+    return replay_call(MRPIZ_CALL_INIT, 0, 0, 0);
+}
+
+void mrpiz_close() {
+    uint64_t recorded_ns = 0;
+
+    replay_call(MRPIZ_CALL_CLOSE, 0, 0, 0);
+    for (size_t i = 0; i < cursor; i++) {
+        recorded_ns += records[i].duration_ns;
+    }
+    printf("Rejeu : %lu appels rejoués sur %zu enregistrés, %lu divergences, %lu sautés, "
+           "%lu consignes moteur différentes\n",
+           answered, record_nb, divergences, skipped, command_mismatches);
+    printf("Rejeu : %.3f ms passés sur le lien pendant l'enregistrement\n", (double)recorded_ns / 1e6);
+    if (mapping != NULL) {
+        munmap(mapping, mapping_size);
+        mapping = NULL;
+        records = NULL;
+    }
+}
+
+int mrpiz_motor_set(mrpiz_motor_id id, int cmd) {
+    return replay_call(MRPIZ_CALL_MOTOR_SET, id, cmd, 0);
+}
+
+int mrpiz_motor_encoder_get(mrpiz_motor_id id) {
+    return replay_call(MRPIZ_CALL_ENCODER_GET, id, 0, 0);
+}
+
+int mrpiz_motor_encoder_reset(mrpiz_motor_id id) {
+    return replay_call(MRPIZ_CALL_ENCODER_RESET, id, 0, 0);
+}
+
+int mrpiz_proxy_sensor_get(mrpiz_proxy_sensor_id id) {
+    return replay_call(MRPIZ_CALL_PROXY_SENSOR_GET, id, 0, 255);
+}
+
+int mrpiz_led_rgb_set(mrpiz_led_rgb_color_t color) {
+    return replay_call(MRPIZ_CALL_LED_RGB_SET, color, 0, 0);
+}
+
+int mrpiz_battery_level(void) {
+    return replay_call(MRPIZ_CALL_BATTERY_LEVEL, 0, 0, 100);
+}
+
+float mrpiz_battery_voltage(void) {
+    return -1.0f;  // Not traced
+}
+
+char const *mrpiz_error_msg() {
+    return "rejeu d'une trace mrpiz";
+}
+
+void mrpiz_error_print(char *msg) {
+    fprintf(stderr, "%s : %s\n", msg, mrpiz_error_msg());
+}
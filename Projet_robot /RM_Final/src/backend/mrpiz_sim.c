@@ -0,0 +1,333 @@
+/**
+ * @file mrpiz_sim.c
+ * @brief Native kinematic simulator backend of the mrpiz API.
+ *
+ * Build with : make clean && make BACKEND=sim
+ */
+
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "mrpiz.h"
+#include "mrpiz_sim.h"
+
+/** @brief Maximum number of walls in the arena. */
+#define SIM_MAX_WALLS 128
+/** @brief Number of proximity sensors. */
+#define SIM_SENSOR_NB 5
+/** @brief Distance from the robot center to the sensors (in mm). */
+#define SIM_SENSOR_OFFSET_MM 35.0
+/** @brief Battery drain (in percent per virtual second). */
+#define SIM_BATTERY_DRAIN_PER_S (1.0 / 36.0)
+
+#define SIM_PI 3.14159265358979323846
+#define SIM_STEPS_PER_MM (MRPIZ_ENCODE_PER_TURN / (SIM_PI * MRPIZ_SIM_WHEEL_DIAMETER_MM))
+
+/**
+ * A wall segment of the arena.
+ */
+typedef struct {
+    double x1, y1, x2, y2;
+} sim_wall_t;
+
+/**
+ * Default arena: a 1500 x 1000 mm box with two inner walls.
+ */
+static const sim_wall_t default_walls[] = {
+    {0, 0, 1500, 0}, {1500, 0, 1500, 1000}, {1500, 1000, 0, 1000}, {0, 1000, 0, 0},
+    {500, 0, 500, 600}, {1000, 1000, 1000, 400}
+};
+
+// Sensor directions relative to the heading, indexed by mrpiz_proxy_sensor_id - 1
+static const double sensor_angles[SIM_SENSOR_NB] = {
+    80.0 * SIM_PI / 180.0, 40.0 * SIM_PI / 180.0, 0.0, -40.0 * SIM_PI / 180.0, -80.0 * SIM_PI / 180.0
+};
+
+/** @brief Initial pose of the robot. */
+#define SIM_START_X_MM 250.0
+#define SIM_START_Y_MM 200.0
+#define SIM_START_THETA 0.0
+
+static sim_wall_t walls[SIM_MAX_WALLS];  // Arena walls
+static int wall_nb = 0;                  // Number of walls
+static double x, y, theta;               // True pose (mm, mm, rad)
+static int command[2];                   // Motor commands (percent)
+static double wheel_speed[2];            // Wheel speeds (steps per second)
+static double encoder[2];                // Encoder positions (steps)
+static uint64_t now_ns = 0;              // Virtual clock
+static mrpiz_led_rgb_color_t led = MRPIZ_LED_OFF; // LED color
+static pthread_mutex_t sim_lock = PTHREAD_MUTEX_INITIALIZER; // Control and UI threads
+
+// Distance from a point to a wall segment
+static double wall_distance(const sim_wall_t *w, double px, double py) {
+    double dx = w->x2 - w->x1, dy = w->y2 - w->y1;
+    double len2 = dx * dx + dy * dy;
+    double t = len2 > 0 ? ((px - w->x1) * dx + (py - w->y1) * dy) / len2 : 0;
+    if (t < 0) t = 0;
+    if (t > 1) t = 1;
+    return hypot(w->x1 + t * dx - px, w->y1 + t * dy - py);
+}
+
+// Checks if the robot body overlaps a wall at a given position
+static int collides(double px, double py) {
+    for (int i = 0; i < wall_nb; i++) {
+        if (wall_distance(&walls[i], px, py) < MRPIZ_SIM_ROBOT_RADIUS_MM) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Casts a ray and gives the distance to the nearest wall (capped to the sensor range)
+static double ray_cast(double ox, double oy, double angle) {
+    double rx = cos(angle), ry = sin(angle);
+    double best = MRPIZ_SIM_SENSOR_RANGE_MM;
+
+    for (int i = 0; i < wall_nb; i++) {
+        double sx = walls[i].x2 - walls[i].x1, sy = walls[i].y2 - walls[i].y1;
+        double denom = rx * sy - ry * sx;
+        if (fabs(denom) < 1e-12) {
+            continue;  // Parallel
+        }
+        double qx = walls[i].x1 - ox, qy = walls[i].y1 - oy;
+        double t = (qx * sy - qy * sx) / denom;  // Along the ray
+        double u = (qx * ry - qy * rx) / denom;  // Along the wall
+        if (t >= 0 && u >= 0 && u <= 1 && t < best) {
+            best = t;
+        }
+    }
+    return best;
+}
+
+// Integrates the motion over one physics step
+static void step(double dt) {
+    double alpha = dt / MRPIZ_SIM_MOTOR_TAU_S;
+    double travel[2];
+
+    for (int w = 0; w < 2; w++) {
+        double target = command[w] * MRPIZ_SIM_MAX_STEPS_PER_S / 100.0;
+        wheel_speed[w] += (target - wheel_speed[w]) * (alpha < 1 ? alpha : 1);
+        encoder[w] += wheel_speed[w] * dt;  // Wheels slip against walls: encoders keep counting
+        travel[w] = wheel_speed[w] * dt / SIM_STEPS_PER_MM;
+    }
+
+    double distance = (travel[MRPIZ_MOTOR_LEFT] + travel[MRPIZ_MOTOR_RIGHT]) / 2.0;
+    double rotation = (travel[MRPIZ_MOTOR_RIGHT] - travel[MRPIZ_MOTOR_LEFT]) / MRPIZ_SIM_WHEEL_BASE_MM;
+    double mid = theta + rotation / 2.0;
+    double nx = x + distance * cos(mid);
+    double ny = y + distance * sin(mid);
+
+    theta = remainder(theta + rotation, 2.0 * SIM_PI);
+    if (!collides(nx, ny)) {
+        x = nx;
+        y = ny;
+    }
+}
+
+// Loads the default arena on the first use
+static void ensure_arena(void) {
+    if (wall_nb == 0) {
+        wall_nb = (int)(sizeof(default_walls) / sizeof(default_walls[0]));
+        for (int i = 0; i < wall_nb; i++) {
+            walls[i] = default_walls[i];
+        }
+    }
+}
+
+void mrpiz_sim_advance_ns(uint64_t ns) {
+    pthread_mutex_lock(&sim_lock);
+    ensure_arena();
+    uint64_t end = now_ns + ns;
+    while (now_ns < end) {
+        uint64_t dt = end - now_ns < MRPIZ_SIM_STEP_NS ? end - now_ns : MRPIZ_SIM_STEP_NS;
+        step((double)dt / 1e9);
+        now_ns += dt;
+    }
+    pthread_mutex_unlock(&sim_lock);
+}
+
+uint64_t mrpiz_sim_now_ns(void) {
+    pthread_mutex_lock(&sim_lock);
+    uint64_t now = now_ns;
+    pthread_mutex_unlock(&sim_lock);
+    return now;
+}
+
+void mrpiz_sim_get_pose(double *x_mm, double *y_mm, double *theta_rad) {
+    pthread_mutex_lock(&sim_lock);
+    *x_mm = x;
+    *y_mm = y;
+    *theta_rad = theta;
+    pthread_mutex_unlock(&sim_lock);
+}
+
+void mrpiz_sim_set_pose(double x_mm, double y_mm, double theta_rad) {
+    pthread_mutex_lock(&sim_lock);
+    x = x_mm;
+    y = y_mm;
+    theta = theta_rad;
+    wheel_speed[0] = wheel_speed[1] = 0;
+    command[0] = command[1] = 0;
+    pthread_mutex_unlock(&sim_lock);
+}
+
+int mrpiz_sim_load_arena(const char *path) {
+    sim_wall_t loaded[SIM_MAX_WALLS];
+    int count = 0;
+    FILE *file = fopen(path, "r");
+
+    if (file == NULL) {
+        perror(path);
+        return -1;
+    }
+    while (count < SIM_MAX_WALLS &&
+           fscanf(file, "%lf %lf %lf %lf", &loaded[count].x1, &loaded[count].y1,
+                  &loaded[count].x2, &loaded[count].y2) == 4) {
+        count++;
+    }
+    fclose(file);
+    if (count == 0) {
+        fprintf(stderr, "%s : aucun mur\n", path);
+        return -1;
+    }
+
+    pthread_mutex_lock(&sim_lock);
+    for (int i = 0; i < count; i++) {
+        walls[i] = loaded[i];
+    }
+    wall_nb = count;
+    pthread_mutex_unlock(&sim_lock);
+    return count;
+}
+
+double mrpiz_sim_wall_distance(double x_mm, double y_mm) {
+    double best = INFINITY;
+
+    pthread_mutex_lock(&sim_lock);
+    ensure_arena();
+    for (int i = 0; i < wall_nb; i++) {
+        best = fmin(best, wall_distance(&walls[i], x_mm, y_mm));
+    }
+    pthread_mutex_unlock(&sim_lock);
+    return best;
+}
+
+void mrpiz_sim_reset(void) {
+    pthread_mutex_lock(&sim_lock);
+    x = SIM_START_X_MM;
+    y = SIM_START_Y_MM;
+    theta = SIM_START_THETA;
+    command[0] = command[1] = 0;
+    wheel_speed[0] = wheel_speed[1] = 0;
+    encoder[0] = encoder[1] = 0;
+    now_ns = 0;
+    led = MRPIZ_LED_OFF;
+    pthread_mutex_unlock(&sim_lock);
+}
+
+/*
+ * mrpiz API.
+ */
+
+int mrpiz_init_intox(const char *address, const int port) {
+    (void)address;
+    (void)port;
+    const char *arena = getenv(MRPIZ_SIM_ARENA_ENV);
+
+    mrpiz_sim_reset();
+    if (arena != NULL && mrpiz_sim_load_arena(arena) < 0) {
+        return -1;
+    }
+    pthread_mutex_lock(&sim_lock);
+    ensure_arena();
+    pthread_mutex_unlock(&sim_lock);
+    return 0;
+}
+
+void mrpiz_close() {
+    pthread_mutex_lock(&sim_lock);
+    command[0] = command[1] = 0;
+    pthread_mutex_unlock(&sim_lock);
+}
+
+int mrpiz_motor_set(mrpiz_motor_id id, int cmd) {
+    if (cmd > 100) cmd = 100;
+    if (cmd < -100) cmd = -100;
+
+    pthread_mutex_lock(&sim_lock);
+    if (id == MRPIZ_MOTOR_BOTH) {
+        command[MRPIZ_MOTOR_LEFT] = command[MRPIZ_MOTOR_RIGHT] = cmd;
+    } else if (id == MRPIZ_MOTOR_LEFT || id == MRPIZ_MOTOR_RIGHT) {
+        command[id] = cmd;
+    } else {
+        pthread_mutex_unlock(&sim_lock);
+        return -1;
+    }
+    pthread_mutex_unlock(&sim_lock);
+    return 0;
+}
+
+int mrpiz_motor_encoder_get(mrpiz_motor_id id) {
+    int value;
+
+    if (id != MRPIZ_MOTOR_LEFT && id != MRPIZ_MOTOR_RIGHT) {
+        return 0;
+    }
+    pthread_mutex_lock(&sim_lock);
+    value = (int)floor(encoder[id]);
+    pthread_mutex_unlock(&sim_lock);
+    return value;
+}
+
+int mrpiz_motor_encoder_reset(mrpiz_motor_id id) {
+    pthread_mutex_lock(&sim_lock);
+    if (id == MRPIZ_MOTOR_BOTH) {
+        encoder[MRPIZ_MOTOR_LEFT] = encoder[MRPIZ_MOTOR_RIGHT] = 0;
+    } else if (id == MRPIZ_MOTOR_LEFT || id == MRPIZ_MOTOR_RIGHT) {
+        encoder[id] = 0;
+    } else {
+        pthread_mutex_unlock(&sim_lock);
+        return -1;
+    }
+    pthread_mutex_unlock(&sim_lock);
+    return 0;
+}
+
+int mrpiz_proxy_sensor_get(mrpiz_proxy_sensor_id id) {
+    double distance;
+
+    if (id < MRPIZ_PROXY_SENSOR_FRONT_LEFT || id > MRPIZ_PROXY_SENSOR_FRONT_RIGHT) {
+        return -1;
+    }
+    pthread_mutex_lock(&sim_lock);
+    ensure_arena();
+    double angle = theta + sensor_angles[id - MRPIZ_PROXY_SENSOR_FRONT_LEFT];
+    distance = ray_cast(x + SIM_SENSOR_OFFSET_MM * cos(angle), y + SIM_SENSOR_OFFSET_MM * sin(angle), angle);
+    pthread_mutex_unlock(&sim_lock);
+    return (int)lround(distance);  // 1 unit per mm, saturated at the sensor range
+}
+
+int mrpiz_led_rgb_set(mrpiz_led_rgb_color_t color) {
+    pthread_mutex_lock(&sim_lock);
+    led = color;
+    pthread_mutex_unlock(&sim_lock);
+    return 0;
+}
+
+int mrpiz_battery_level(void) {
+    double level = 100.0 - (double)mrpiz_sim_now_ns() / 1e9 * SIM_BATTERY_DRAIN_PER_S;
+    return level > 0 ? (int)level : 0;
+}
+
+float mrpiz_battery_voltage(void) {
+    return 3.0f + 1.2f * (float)mrpiz_battery_level() / 100.0f;
+}
+
+char const *mrpiz_error_msg() {
+    return "simulateur natif mrpiz";
+}
+
+void mrpiz_error_print(char *msg) {
+    fprintf(stderr, "%s : %s\n", msg, mrpiz_error_msg());
+}
@@ -0,0 +1,92 @@
+#ifndef MRPIZ_SIM_H
+#define MRPIZ_SIM_H
+
+#include <stdint.h>
+
+/**
+ * @file mrpiz_sim.h
+ * @brief Native kinematic simulator implementing the mrpiz API.
+ *
+ * Linked instead of libintoxmrpiz.a with "make BACKEND=sim". The robot is
+ * a differential drive with first-order motors, in a 2D arena made of
+ * wall segments; the five proximity sensors are ray cast against the walls.
+ * The simulator runs on a virtual clock: time only advances when
+ * mrpiz_sim_advance_ns() is called, so whole missions run in milliseconds
+ * and give the same result on every run.
+ */
+
+/** @brief Environment variable giving an arena file (one "x1 y1 x2 y2" wall per line, in mm). */
+#define MRPIZ_SIM_ARENA_ENV "MRPIZ_SIM_ARENA"
+
+/** @brief Distance between the two wheels (in mm). */
+#define MRPIZ_SIM_WHEEL_BASE_MM 75.0
+/** @brief Diameter of the wheels (in mm). */
+#define MRPIZ_SIM_WHEEL_DIAMETER_MM 32.0
+/** @brief Wheel speed at a 100 % command (in encoder steps per second). */
+#define MRPIZ_SIM_MAX_STEPS_PER_S 780.0
+/** @brief Time constant of the motors (in seconds). */
+#define MRPIZ_SIM_MOTOR_TAU_S 0.05
+/** @brief Radius of the robot body, used for collisions (in mm). */
+#define MRPIZ_SIM_ROBOT_RADIUS_MM 40.0
+/** @brief Range of the proximity sensors (in mm, 1 sensor unit per mm). */
+#define MRPIZ_SIM_SENSOR_RANGE_MM 255.0
+/** @brief Integration step of the physics (in nanoseconds). */
+#define MRPIZ_SIM_STEP_NS 1000000ULL
+
+/**
+ * @brief Advances the virtual clock and integrates the robot motion.
+ *
+ * @param ns The duration to simulate (in nanoseconds).
+ */
+void mrpiz_sim_advance_ns(uint64_t ns);
+
+/**
+ * @brief Gets the virtual time elapsed since the initialization.
+ *
+ * @return The virtual time (in nanoseconds).
+ */
+uint64_t mrpiz_sim_now_ns(void);
+
+/**
+ * @brief Gets the true pose of the simulated robot.
+ *
+ * @param x_mm Where to store the x position (in mm).
+ * @param y_mm Where to store the y position (in mm).
+ * @param theta_rad Where to store the heading (in radians, counterclockwise from x).
+ */
+void mrpiz_sim_get_pose(double *x_mm, double *y_mm, double *theta_rad);
+
+/**
+ * @brief Places the simulated robot (stopped) at a given pose.
+ *
+ * @param x_mm The x position (in mm).
+ * @param y_mm The y position (in mm).
+ * @param theta_rad The heading (in radians).
+ */
+void mrpiz_sim_set_pose(double x_mm, double y_mm, double theta_rad);
+
+/**
+ * @brief Replaces the arena walls with the ones of a file.
+ *
+ * @param path The arena file (one "x1 y1 x2 y2" wall per line, in mm).
+ * @return The number of walls loaded, -1 on error (the arena is unchanged).
+ */
+int mrpiz_sim_load_arena(const char *path);
+
+/**
+ * @brief Gets the distance from a point to the nearest wall of the arena.
+ *
+ * Ground truth for the maps built by the application.
+ *
+ * @param x_mm The x position (in mm).
+ * @param y_mm The y position (in mm).
+ * @return The distance to the nearest wall (in mm).
+ */
+double mrpiz_sim_wall_distance(double x_mm, double y_mm);
+
+/**
+ * @brief Puts the simulator back in its initial state (pose, motors, encoders, clock).
+ */
+void mrpiz_sim_reset(void);
+
+#endif // MRPIZ_SIM_H
@@ -0,0 +1,745 @@
+/**
+ * @file control_bench.c
+ * @brief Benchmark suite of the control path hot spots ("make bench").
+ *
+ * Runs against the native simulator (backend/mrpiz_sim.c) and measures:
+ * - status acquisition (robot_refresh_status) and reads (robot_get_status),
+ * - the decision cost of pilot_start_move(), pilot_stop_at_target() and
+ *   follow_right_wall(),
+ * - the jitter of the control loop, ticking on the real clock,
+ * - the duration and overshoot of single moves, with and without motion profile,
+ *   of a long forward move in open space, beyond the range of the sensors,
+ *   and of a forward move held by a wall until it fails,
+ * - the mission time of path1 and path2 on the virtual clock, stopping at
+ *   every step or blending the moves,
+ * - the replay of path1 through the control loop on the virtual clock: two
+ *   runs must end at the same pose with the same flight records,
+ * - the load time of a long mission file, text and binary,
+ * - the cost and the accuracy of the occupancy grid, mapping the arena
+ *   while following the wall,
+ * - the latency of the incremental replanning on a 200 x 200 grid, against
+ *   a search from scratch on the same map,
+ * - the false detections and the detection delay of the sensor filters,
+ *   on noisy readings with spikes.
+ *
+ * Results are printed on stdout, one JSON object per line; the messages of
+ * the application are discarded so the output stays machine readable.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "../robot_app/app_manager.h"
+#include "../robot_app/clock.h"
+#include "../robot_app/control_loop.h"
+#include "../robot_app/flight_recorder.h"
+#include "../robot_app/speed_ctrl.h"
+#include "../robot_app/odometry.h"
+#include "../robot_app/motion_profile.h"
+#include "../robot_app/occupancy_grid.h"
+#include "../robot_app/planner.h"
+#include "../robot_app/sensor_filter.h"
+#include "../robot_app/obstacle_model.h"
+#include "../backend/mrpiz_sim.h"
+#include "../utils.h"
+
+/** @brief Number of status acquisitions measured. */
+#define BENCH_REFRESHES 100000UL
+/** @brief Number of calls measured for the cheap functions. */
+#define BENCH_CALLS 1000000UL
+/** @brief Number of wall follower calls timed between two simulation steps. */
+#define BENCH_WALL_BATCH 1000UL
+/** @brief Number of control loop ticks measured for the jitter. */
+#define BENCH_LOOP_TICKS 400UL
+/** @brief Speed of the missions (in %, as choice 5 of the menu). */
+#define BENCH_MISSION_SPEED 50
+/** @brief Cruise speed of the fast missions (in %). */
+#define BENCH_FAST_SPEED 100
+/** @brief Time left to the robot to settle after a move (in virtual nanoseconds). */
+#define BENCH_SETTLE_NS (300 * 1000000ULL)
+/** @brief Start of the long forward move: 860 mm to the east wall, nothing else ahead (in mm). */
+#define BENCH_OPEN_X_MM 600.0
+#define BENCH_OPEN_Y_MM 200.0
+/** @brief Start of the blocked forward move: 70 mm from the wall ahead, too close to move on (in mm). */
+#define BENCH_BLOCKED_X_MM 430.0
+/** @brief Distance of the long forward move (FORWARD units, about 770 mm). */
+#define BENCH_LONG_DISTANCE 1500
+/** @brief Longest mission accepted (in virtual nanoseconds). */
+#define BENCH_MISSION_TIMEOUT_NS (120 * NS_PER_S)
+/** @brief Duration of the wall following mapped (in virtual nanoseconds). */
+#define BENCH_MAPPING_NS (90 * NS_PER_S)
+/** @brief Distance to a wall under which an occupied cell is right (in mm). */
+#define BENCH_MAPPING_WALL_MM (1.5 * OCC_GRID_CELL_MM)
+/** @brief Origin of the grid, so the default arena is inside it (in mm). */
+#define BENCH_MAPPING_ORIGIN_MM (-100.0)
+/** @brief Side of the planning grid (in cells). */
+#define BENCH_PLANNER_SIZE 200
+/** @brief One cell in BENCH_PLANNER_DENSITY is an obstacle at the start. */
+#define BENCH_PLANNER_DENSITY 8
+/** @brief Number of replannings measured. */
+#define BENCH_PLANNER_REPLANS 50
+/** @brief Cells travelled by the robot between two replannings. */
+#define BENCH_PLANNER_ADVANCE 6
+/** @brief Obstacles discovered ahead of the robot before each replanning. */
+#define BENCH_PLANNER_DISCOVERED 3
+/** @brief Number of times an obstacle appears in front of the filtered sensors. */
+#define BENCH_FILTER_EPISODES 200
+/** @brief Samples without obstacle before it appears. */
+#define BENCH_FILTER_FREE_SAMPLES 300
+/** @brief Samples with the obstacle. */
+#define BENCH_FILTER_OBSTACLE_SAMPLES 50
+/** @brief Reading without obstacle, and reading of the obstacle. */
+#define BENCH_FILTER_FREE_READING 200
+#define BENCH_FILTER_OBSTACLE_READING 60
+/** @brief Amplitude of the noise of the readings (uniform, +/-). */
+#define BENCH_FILTER_NOISE 10
+/** @brief One sample in BENCH_FILTER_SPIKE_RATE is a wrong close reading. */
+#define BENCH_FILTER_SPIKE_RATE 50
+/** @brief Number of moves of the mission file loaded. */
+#define BENCH_MISSION_FILE_STEPS 10000
+/** @brief Number of loads measured per mission form. */
+#define BENCH_MISSION_LOADS 100UL
+/** @brief Text mission written for the load measurement. */
+#define BENCH_MISSION_TEXT "../bin/bench_mission.txt"
+/** @brief Binary mission written for the load measurement. */
+#define BENCH_MISSION_BINARY "../bin/bench_mission.bin"
+/** @brief Recordings of the two runs of the replay. */
+#define BENCH_REPLAY_FIRST "../bin/bench_replay_1.rec"
+#define BENCH_REPLAY_SECOND "../bin/bench_replay_2.rec"
+/** @brief Records of a replay recording (more than the ticks of the mission, so the ring never wraps). */
+#define BENCH_REPLAY_CAPACITY 8192
+/** @brief Period of the completion checks of a path run (in microseconds of real time). */
+#define BENCH_PATH_POLL_US 100
+
+static FILE *results;                 // Where the results go (the original stdout)
+static unsigned long loop_ticks;      // Ticks done by the jitter measurement
+static long travel_steps;             // Travel of both wheels counted by sim_tick(), resets included
+static int travel_encoder[2];         // Encoder values seen by the previous sim_tick()
+static uint32_t travel_resets;        // Encoder reset counter seen by the previous sim_tick()
+
+// Prints the result of a per-call measurement
+static void emit_rate(const char *name, unsigned long iterations, uint64_t elapsed_ns) {
+    double ns_per_op = (double)elapsed_ns / (double)iterations;
+    fprintf(results, "{\"bench\":\"%s\",\"iterations\":%lu,\"ns_per_op\":%.1f,\"ops_per_s\":%.0f}\n",
+            name, iterations, ns_per_op, 1e9 / ns_per_op);
+    fflush(results);
+}
+
+// Puts the robot back at its start pose, or at the given one, stopped, with a fresh snapshot:
+// the speed controller and the sensor filters forget the previous run, so every run starts from the same state
+static void place_robot(const odometry_pose_t *start) {
+    double x, y, theta;
+
+    speed_ctrl_reset();
+    sensor_filter_reset();
+    speed_ctrl_set_target(0, 0);
+    mrpiz_sim_reset();
+    if (start != NULL) {
+        mrpiz_sim_set_pose(start->x_mm, start->y_mm, start->theta_rad);
+    }
+    robot_reset_wheel_pos();
+    robot_refresh_status();
+    odometry_update(0);
+    mrpiz_sim_get_pose(&x, &y, &theta);
+    odometry_set_pose(x, y, theta);
+}
+
+// Puts the robot back at its start pose, stopped, with a fresh snapshot
+static void reset_robot(void) {
+    place_robot(NULL);
+}
+
+// Simulates one control period, then acquires the status as a tick does
+static void sim_tick(void) {
+    mrpiz_sim_advance_ns(NS_PER_S / CONTROL_RATE_HZ);
+    robot_refresh_status();
+    odometry_update(NS_PER_S / CONTROL_RATE_HZ);
+    occupancy_grid_update();
+
+    // Mean wheel travel, carried across the encoder resets
+    robot_snapshot_t snap = robot_get_snapshot();
+    int left = snap.status.left_encoder, right = snap.status.right_encoder;
+    if (snap.encoder_resets == travel_resets) {
+        left -= travel_encoder[0];
+        right -= travel_encoder[1];
+    }
+    travel_steps += labs(left) + labs(right);
+    travel_encoder[0] = snap.status.left_encoder;
+    travel_encoder[1] = snap.status.right_encoder;
+    travel_resets = snap.encoder_resets;
+}
+
+// Runs a path through the control loop on the virtual clock, as the application does, until it ends:
+// returns its final status, PATH_IN_PROGRESS if it timed out, PATH_NOT_STARTED if the loop could not start
+static path_status_t run_path(const path_t *path, int speed) {
+    copilot_set_path(path->moves, path->steps);
+    copilot_set_speed(speed);
+    copilot_start_path();
+    if (start_path_execution() != 0) {
+        return PATH_NOT_STARTED;
+    }
+    while (!check_path_completion()) {
+        if (mrpiz_sim_now_ns() > BENCH_MISSION_TIMEOUT_NS) {
+            control_loop_stop();
+            return PATH_IN_PROGRESS;
+        }
+        usleep(BENCH_PATH_POLL_US);
+    }
+    return copilot_is_path_completed() ? PATH_COMPLETED : PATH_FAILED;
+}
+
+// Enables or disables the motion profiles
+static void use_profile(bool enabled) {
+    motion_profile_config_t config = motion_profile_get_config();
+    config.enabled = enabled;
+    motion_profile_configure(&config);
+}
+
+// Status acquisition (one link sweep) and snapshot reads
+static void bench_status(void) {
+    volatile int sink = 0;
+    uint64_t start;
+
+    reset_robot();
+    start = monotonic_ns();
+    for (unsigned long i = 0; i < BENCH_REFRESHES; i++) {
+        robot_refresh_status();
+    }
+    emit_rate("robot_refresh_status", BENCH_REFRESHES, monotonic_ns() - start);
+
+    start = monotonic_ns();
+    for (unsigned long i = 0; i < BENCH_CALLS; i++) {
+        sink += robot_get_status().sensors[SENSOR_CENTER];
+    }
+    emit_rate("robot_get_status", BENCH_CALLS, monotonic_ns() - start);
+    (void)sink;
+}
+
+// Decision cost of the pilot, the robot standing still
+static void bench_pilot(void) {
+    const move_t moves[] = {
+        {FORWARD, {PATH_DISTANCE, 0}, BENCH_MISSION_SPEED},
+        {ROTATION, {RIGHT, 0}, BENCH_MISSION_SPEED},
+        {ROTATION, {LEFT, 0}, BENCH_MISSION_SPEED},
+        {ROTATION, {U_TURN, 0}, BENCH_MISSION_SPEED}
+    };
+    volatile int sink = 0;
+    uint64_t start;
+
+    reset_robot();
+    start = monotonic_ns();
+    for (unsigned long i = 0; i < BENCH_REFRESHES; i++) {
+        pilot_start_move(moves[i % 4]);
+    }
+    emit_rate("pilot_start_move", BENCH_REFRESHES, monotonic_ns() - start);
+
+    // A rotation never reaches its target while the robot does not move
+    reset_robot();
+    pilot_start_move(moves[1]);
+    start = monotonic_ns();
+    for (unsigned long i = 0; i < BENCH_CALLS; i++) {
+        sink += pilot_stop_at_target();
+    }
+    emit_rate("pilot_stop_at_target", BENCH_CALLS, monotonic_ns() - start);
+    speed_ctrl_set_target(0, 0);
+    (void)sink;
+}
+
+// Decision cost of the wall follower, the robot moving between two batches
+static void bench_wall_following(void) {
+    uint64_t elapsed = 0;
+
+    reset_robot();
+    pilot_reset_wall_following();
+    for (unsigned long done = 0; done < BENCH_CALLS; done += BENCH_WALL_BATCH) {
+        uint64_t start = monotonic_ns();
+        for (unsigned long i = 0; i < BENCH_WALL_BATCH; i++) {
+            follow_right_wall();
+        }
+        elapsed += monotonic_ns() - start;
+        mrpiz_sim_advance_ns(NS_PER_S / CONTROL_RATE_HZ);
+        robot_refresh_status();
+    }
+    emit_rate("follow_right_wall", BENCH_CALLS, elapsed);
+    speed_ctrl_set_target(0, 0);
+}
+
+// Tick of the jitter measurement: one wall follower step on the simulated robot,
+// which the real clock moves as the time goes by
+static int jitter_tick(void *unused) {
+    (void)unused;
+    robot_hold_commands();
+    robot_refresh_status();
+    odometry_update(NS_PER_S / CONTROL_RATE_HZ);
+    occupancy_grid_update();
+    follow_right_wall();
+    speed_ctrl_update(NS_PER_S / CONTROL_RATE_HZ);
+    robot_flush_commands();
+    return ++loop_ticks >= BENCH_LOOP_TICKS;
+}
+
+// Wake-up jitter of the control loop, on the real clock
+static void bench_control_loop(void) {
+    control_loop_config_t config = {CONTROL_RATE_HZ, CONTROL_REALTIME, CONTROL_PRIORITY};
+    control_loop_stats_t s;
+
+    clock_select(&clock_real);
+    reset_robot();
+    pilot_reset_wall_following();
+    loop_ticks = 0;
+    if (control_loop_start(&config, jitter_tick, NULL) != 0) {
+        fprintf(results, "{\"bench\":\"control_loop\",\"error\":\"start\"}\n");
+        return;
+    }
+    while (control_loop_is_running()) {
+        usleep(10000);
+    }
+    control_loop_stop();
+    speed_ctrl_set_target(0, 0);
+    clock_select(&clock_virtual);
+
+    s = control_loop_get_stats();
+    fprintf(results, "{\"bench\":\"control_loop\",\"rate_hz\":%d,\"realtime\":%s,\"ticks\":%lu,"
+            "\"overruns\":%lu,\"mean_jitter_ns\":%llu,\"max_jitter_ns\":%llu,"
+            "\"min_period_ns\":%llu,\"max_period_ns\":%llu,\"max_tick_ns\":%llu}\n",
+            CONTROL_RATE_HZ, s.realtime ? "true" : "false", s.ticks, s.overruns,
+            (unsigned long long)s.mean_jitter_ns, (unsigned long long)s.max_jitter_ns,
+            (unsigned long long)s.min_period_ns, (unsigned long long)s.max_period_ns,
+            (unsigned long long)s.max_tick_ns);
+    fflush(results);
+}
+
+// Runs a single move from a standstill, at the start pose or at the given one, and measures where the robot stops
+static void bench_move(const char *name, move_t move, int target_steps, bool profiled, const odometry_pose_t *start) {
+    unsigned long ticks = 0;
+    uint64_t settle_end;
+
+    use_profile(profiled);
+    place_robot(start);
+    sim_tick();
+    travel_steps = 0;
+    pilot_start_move(move);
+    move_status_t status;
+    while ((status = pilot_stop_at_target()) != MOVE_DONE && status != MOVE_FAILED &&
+           mrpiz_sim_now_ns() < BENCH_MISSION_TIMEOUT_NS) {
+        speed_ctrl_update(NS_PER_S / CONTROL_RATE_HZ);
+        sim_tick();
+        ticks++;
+    }
+    double move_s = (double)ticks / CONTROL_RATE_HZ;
+    settle_end = mrpiz_sim_now_ns() + BENCH_SETTLE_NS;
+    while (mrpiz_sim_now_ns() < settle_end) {
+        sim_tick();
+    }
+    long travel = travel_steps / 2;  // Mean of the two wheels
+    fprintf(results, "{\"bench\":\"%s\",\"profile\":%s,\"speed_pct\":%d,\"target_steps\":%d,"
+            "\"move_s\":%.3f,\"travel_steps\":%ld,\"overshoot_steps\":%ld,\"completed\":%s,\"failed\":%s}\n",
+            name, profiled ? "true" : "false", move.speed, target_steps, move_s,
+            travel, travel - target_steps, status == MOVE_DONE ? "true" : "false", status == MOVE_FAILED ? "true" : "false");
+    fflush(results);
+    use_profile(true);
+}
+
+// Runs a whole path through the control loop on the virtual clock
+static double bench_mission(const char *name, int path_choice, int speed, bool profiled, bool blended,
+                            double stop_and_go_s) {
+    path_status_t status;
+    double x, y, theta;
+    uint64_t start;
+    const path_t *path;
+
+    use_profile(profiled);
+    copilot_set_blending(blended);
+    reset_robot();
+    path = get_path(path_choice);
+    if (path == NULL) {
+        fprintf(results, "{\"bench\":\"%s\",\"error\":\"path\"}\n", name);
+        return 0.0;
+    }
+    robot_reset_command_stats();
+    start = monotonic_ns();
+    status = run_path(path, speed);
+    uint64_t wall_ns = monotonic_ns() - start;
+    robot_command_stats_t commands = robot_get_command_stats();
+    speed_ctrl_set_target(0, 0);
+
+    unsigned long ticks = control_loop_get_stats().ticks;
+    speed_ctrl_stats_t tracking = speed_ctrl_get_stats();
+    odometry_pose_t estimate = odometry_get_pose();
+    double mission_s = (double)mrpiz_sim_now_ns() / 1e9;
+    mrpiz_sim_get_pose(&x, &y, &theta);
+    fprintf(results, "{\"bench\":\"%s\",\"profile\":%s,\"blend\":%s,\"speed_pct\":%d,\"completed\":%s,\"failed\":%s,"
+            "\"steps\":%d,\"blends\":%d,\"saved_s\":%.3f,\"ticks\":%lu,\"mission_s\":%.3f,\"wall_ms\":%.3f,\"x_mm\":%.1f,\"y_mm\":%.1f,\"theta_rad\":%.3f,"
+            "\"speed_rms_error_pct\":%.2f,\"max_heading_error_steps\":%d,"
+            "\"odometry_error_mm\":%.1f,\"odometry_error_rad\":%.3f,"
+            "\"speed_requests\":%lu,\"motor_calls\":%lu,\"motor_calls_saved\":%lu}\n",
+            name, profiled ? "true" : "false", blended ? "true" : "false", speed,
+            status == PATH_COMPLETED ? "true" : "false", status == PATH_FAILED ? "true" : "false", path->steps, copilot_get_blend_count(),
+            stop_and_go_s > 0.0 ? stop_and_go_s - mission_s : 0.0, ticks, mission_s, (double)wall_ns / 1e6, x, y, theta,
+            tracking.rms_error, tracking.max_heading_error,
+            hypot(estimate.x_mm - x, estimate.y_mm - y), fabs(remainder(estimate.theta_rad - theta, 2.0 * M_PI)),
+            commands.speed_requests, commands.motor_calls, commands.motor_calls_saved);
+    fflush(results);
+    use_profile(true);
+    copilot_set_blending(COPILOT_BLENDING_DEFAULT);
+    return mission_s;
+}
+
+// Maps the arena while following the wall, then checks the grid against the true walls
+static void bench_mapping(void) {
+    unsigned long occupied = 0, on_wall = 0, free_cells = 0, free_on_wall = 0;
+
+    reset_robot();
+    pilot_reset_wall_following();
+    occupancy_grid_reset(BENCH_MAPPING_ORIGIN_MM, BENCH_MAPPING_ORIGIN_MM);
+    while (mrpiz_sim_now_ns() < BENCH_MAPPING_NS) {
+        sim_tick();
+        follow_right_wall();
+        speed_ctrl_update(NS_PER_S / CONTROL_RATE_HZ);
+    }
+    speed_ctrl_set_target(0, 0);
+
+    for (int cy = 0; cy < OCC_GRID_SIZE; cy++) {
+        for (int cx = 0; cx < OCC_GRID_SIZE; cx++) {
+            cell_state_t state = occupancy_grid_cell_state(cx, cy);
+            double x, y;
+            if (state == CELL_UNKNOWN) {
+                continue;
+            }
+            occupancy_grid_to_position(cx, cy, &x, &y);
+            double wall = mrpiz_sim_wall_distance(x, y);
+            if (state == CELL_OCCUPIED) {
+                occupied++;
+                on_wall += wall <= BENCH_MAPPING_WALL_MM;
+            } else {
+                free_cells++;
+                free_on_wall += wall < OCC_GRID_CELL_MM / 2.0;  // The wall crosses the cell
+            }
+        }
+    }
+    occupancy_grid_stats_t s = occupancy_grid_get_stats();
+    fprintf(results, "{\"bench\":\"occupancy_grid\",\"updates\":%llu,\"mean_update_ns\":%.1f,\"max_update_ns\":%llu,"
+            "\"max_cells_per_update\":%u,\"occupied_cells\":%lu,\"occupied_on_wall_pct\":%.1f,"
+            "\"free_cells\":%lu,\"free_on_wall\":%lu}\n",
+            (unsigned long long)s.updates, s.updates > 0 ? (double)s.total_ns / (double)s.updates : 0.0,
+            (unsigned long long)s.max_update_ns, (unsigned)s.max_cells,
+            occupied, occupied > 0 ? 100.0 * (double)on_wall / (double)occupied : 0.0, free_cells, free_on_wall);
+    fflush(results);
+}
+
+// Deterministic pseudo-random numbers, the same on every run
+static uint32_t bench_random(uint32_t *state) {
+    *state = *state * 1664525u + 1013904223u;
+    return *state >> 8;
+}
+
+// Replans while the robot walks its route and discovers obstacles on it,
+// incrementally, then from scratch on the same map for comparison
+static void bench_planner(void) {
+    static planner_cell_t route[BENCH_PLANNER_SIZE * BENCH_PLANNER_SIZE];
+    planner_cell_t start = {0, 0}, goal = {BENCH_PLANNER_SIZE - 1, BENCH_PLANNER_SIZE - 1};
+    uint64_t incremental_ns = 0, max_incremental_ns = 0, full_ns = 0;
+    uint64_t incremental_expansions = 0, full_expansions = 0;
+    uint32_t seed = 12345;
+    int replans = 0, mismatches = 0;
+
+    planner_init(BENCH_PLANNER_SIZE, BENCH_PLANNER_SIZE);
+    for (int y = 0; y < BENCH_PLANNER_SIZE; y++) {
+        for (int x = 0; x < BENCH_PLANNER_SIZE; x++) {
+            if (bench_random(&seed) % BENCH_PLANNER_DENSITY == 0) {
+                planner_set_cost((planner_cell_t){x, y}, PLANNER_COST_BLOCKED);
+            }
+        }
+    }
+    planner_set_cost(start, PLANNER_COST_FREE);
+    planner_set_cost(goal, PLANNER_COST_FREE);
+    planner_set_start(start);
+    planner_set_goal(goal);
+    int cost = planner_compute();
+    planner_stats_t first = planner_get_stats();
+
+    while (replans < BENCH_PLANNER_REPLANS && cost >= 0) {
+        int count = planner_get_route(route, BENCH_PLANNER_SIZE * BENCH_PLANNER_SIZE);
+        if (count <= 2 * BENCH_PLANNER_ADVANCE + 2) {
+            break;  // Arrived
+        }
+        // The robot moves on, then sees obstacles on the route ahead (not around the goal, never walled in)
+        start = route[BENCH_PLANNER_ADVANCE];
+        for (int i = 0; i < BENCH_PLANNER_DISCOVERED; i++) {
+            int ahead = BENCH_PLANNER_ADVANCE + 1 +
+                        (int)(bench_random(&seed) % (uint32_t)(count - 2 * BENCH_PLANNER_ADVANCE - 2));
+            planner_set_cost(route[ahead], PLANNER_COST_BLOCKED);
+        }
+        planner_set_start(start);
+        cost = planner_compute();
+        planner_stats_t s = planner_get_stats();
+        incremental_ns += s.last_search_ns;
+        max_incremental_ns = s.last_search_ns > max_incremental_ns ? s.last_search_ns : max_incremental_ns;
+        incremental_expansions += s.last_expansions;
+
+        // Same map and start, from scratch
+        uint64_t begin = monotonic_ns();
+        planner_set_goal(goal);
+        int full_cost = planner_compute();
+        full_ns += monotonic_ns() - begin;
+        full_expansions += planner_get_stats().last_expansions;
+        mismatches += full_cost != cost;
+        replans++;
+    }
+
+    fprintf(results, "{\"bench\":\"planner\",\"size\":%d,\"first_search_ms\":%.3f,\"first_expansions\":%u,"
+            "\"replans\":%d,\"mean_replan_ms\":%.3f,\"max_replan_ms\":%.3f,\"mean_replan_expansions\":%.0f,"
+            "\"mean_full_search_ms\":%.3f,\"mean_full_expansions\":%.0f,\"cost_mismatches\":%d,\"reachable\":%s}\n",
+            BENCH_PLANNER_SIZE, (double)first.last_search_ns / 1e6, (unsigned)first.last_expansions, replans,
+            replans > 0 ? (double)incremental_ns / 1e6 / replans : 0.0, (double)max_incremental_ns / 1e6,
+            replans > 0 ? (double)incremental_expansions / replans : 0.0,
+            replans > 0 ? (double)full_ns / 1e6 / replans : 0.0,
+            replans > 0 ? (double)full_expansions / replans : 0.0, mismatches, cost >= 0 ? "true" : "false");
+    fflush(results);
+}
+
+// Feeds noisy readings with spikes to the filters, then an obstacle: counts
+// the spikes seen as obstacles and the samples taken to see the real one
+static void bench_sensor_filter(const char *name, sensor_filter_config_t config) {
+    uint32_t seed = 777;
+    unsigned long false_detections = 0, spikes = 0, samples = 0;
+    double delay_sum = 0.0;
+    int max_delay = 0;
+    uint64_t elapsed = 0;
+
+    sensor_filter_configure(&config);
+    for (int episode = 0; episode < BENCH_FILTER_EPISODES; episode++) {
+        int delay = -1;
+
+        sensor_filter_reset();
+        for (int i = 0; i < BENCH_FILTER_FREE_SAMPLES + BENCH_FILTER_OBSTACLE_SAMPLES; i++) {
+            bool obstacle = i >= BENCH_FILTER_FREE_SAMPLES;
+            int reading = (obstacle ? BENCH_FILTER_OBSTACLE_READING : BENCH_FILTER_FREE_READING) +
+                          (int)(bench_random(&seed) % (2 * BENCH_FILTER_NOISE + 1)) - BENCH_FILTER_NOISE;
+            if (!obstacle && bench_random(&seed) % BENCH_FILTER_SPIKE_RATE == 0) {
+                reading = (int)(bench_random(&seed) % BENCH_FILTER_OBSTACLE_READING) - 1;  // -1: link error
+                spikes++;
+            }
+            int raw[SENSOR_NB], filtered[SENSOR_NB];
+            for (int s = 0; s < SENSOR_NB; s++) {
+                raw[s] = reading;
+            }
+            uint64_t start = monotonic_ns();
+            sensor_filter_update(raw, filtered);
+            elapsed += monotonic_ns() - start;
+            samples++;
+
+            bool seen = filtered[SENSOR_CENTER] <= OBSTACLE_FREE_DISTANCE;
+            if (!obstacle && seen && i >= config.window) {
+                false_detections++;
+            } else if (obstacle && seen && delay < 0) {
+                delay = i - BENCH_FILTER_FREE_SAMPLES;
+            }
+        }
+        delay = delay < 0 ? BENCH_FILTER_OBSTACLE_SAMPLES : delay;
+        delay_sum += delay;
+        max_delay = delay > max_delay ? delay : max_delay;
+    }
+
+    sensor_filter_delay_t expected = sensor_filter_get_delay();
+    fprintf(results, "{\"bench\":\"sensor_filter\",\"filter\":\"%s\",\"window\":%d,\"expected_delay_ms\":%.1f,"
+            "\"false_detections\":%lu,\"spikes\":%lu,\"mean_detection_samples\":%.2f,\"max_detection_samples\":%d,"
+            "\"ns_per_update\":%.1f}\n",
+            name, config.window, (double)expected.total_ns / 1e6, false_detections, spikes,
+            delay_sum / BENCH_FILTER_EPISODES, max_delay, (double)elapsed / (double)samples);
+    fflush(results);
+    config = (sensor_filter_config_t)SENSOR_FILTER_DEFAULT_CONFIG;
+    sensor_filter_configure(&config);
+}
+
+// Times the loads of a mission file, validation included
+static void bench_mission_load(const char *name, const char *filename) {
+    mission_t mission;
+    int steps = 0;
+    uint64_t start = monotonic_ns();
+
+    for (unsigned long i = 0; i < BENCH_MISSION_LOADS; i++) {
+        if (mission_load(filename, &mission) != 0) {
+            fprintf(results, "{\"bench\":\"%s\",\"error\":\"load\"}\n", name);
+            return;
+        }
+        steps = mission.path.steps;
+        mission_unload(&mission);
+    }
+    double load_us = (double)(monotonic_ns() - start) / 1e3 / (double)BENCH_MISSION_LOADS;
+    fprintf(results, "{\"bench\":\"%s\",\"steps\":%d,\"iterations\":%lu,\"load_us\":%.1f}\n",
+            name, steps, BENCH_MISSION_LOADS, load_us);
+    fflush(results);
+}
+
+// Writes a long mission in both forms, then times their loads
+static void bench_mission_files(void) {
+    const path_t *zigzag = path_registry_get(PATH_ID_1);
+    move_t *moves = malloc(BENCH_MISSION_FILE_STEPS * sizeof(move_t));
+    FILE *text = fopen(BENCH_MISSION_TEXT, "w");
+    const char *rotations[] = {[LEFT] = "left", [RIGHT] = "right", [U_TURN] = "u_turn"};
+
+    if (moves == NULL || text == NULL) {
+        fprintf(results, "{\"bench\":\"mission_load\",\"error\":\"setup\"}\n");
+        free(moves);
+        if (text != NULL) {
+            fclose(text);
+        }
+        return;
+    }
+    for (int i = 0; i < BENCH_MISSION_FILE_STEPS; i++) {
+        moves[i] = zigzag->moves[i % zigzag->steps];
+        moves[i].speed = 50 + i % 51;
+        if (moves[i].direction == FORWARD) {
+            fprintf(text, "forward %d %d\n", moves[i].parameters[0], moves[i].speed);
+        } else {
+            fprintf(text, "rotate %s %d\n", rotations[moves[i].parameters[0]], moves[i].speed);
+        }
+    }
+    fclose(text);
+    if (mission_save(BENCH_MISSION_BINARY, moves, BENCH_MISSION_FILE_STEPS) == 0) {
+        bench_mission_load("mission_load_text", BENCH_MISSION_TEXT);
+        bench_mission_load("mission_load_binary", BENCH_MISSION_BINARY);
+    }
+    unlink(BENCH_MISSION_TEXT);
+    unlink(BENCH_MISSION_BINARY);
+    free(moves);
+}
+
+// Runs path1 through the control loop on the virtual clock, as the application does, recording each tick
+static bool replay_run(const char *recording, double pose[3]) {
+    const path_t *path;
+    bool completed;
+
+    reset_robot();  // Same state as the other run
+    use_profile(true);
+    copilot_set_blending(COPILOT_BLENDING_DEFAULT);
+    path = get_path(7);
+    if (path == NULL || flight_recorder_open(recording, BENCH_REPLAY_CAPACITY) != 0) {
+        return false;
+    }
+    completed = run_path(path, BENCH_MISSION_SPEED) == PATH_COMPLETED;
+    flight_recorder_close();
+    speed_ctrl_set_target(0, 0);
+    mrpiz_sim_get_pose(&pose[0], &pose[1], &pose[2]);
+    return completed;
+}
+
+// Reads the records of a replay recording, in the order they were written (NULL on error)
+static flight_record_t *read_recording(const char *recording, uint64_t *count) {
+    flight_header_t header;
+    flight_record_t *records = NULL;
+    FILE *file = fopen(recording, "rb");
+
+    *count = 0;
+    if (file == NULL) {
+        return NULL;
+    }
+    if (fread(&header, sizeof(header), 1, file) == 1 && header.magic == FLIGHT_RECORDER_MAGIC &&
+        header.written > 0 && header.written <= header.capacity) {
+        records = malloc((size_t)header.written * sizeof(flight_record_t));
+        if (records != NULL && fread(records, sizeof(flight_record_t), (size_t)header.written, file) == header.written) {
+            *count = header.written;
+        } else {
+            free(records);
+            records = NULL;
+        }
+    }
+    fclose(file);
+    return records;
+}
+
+// Runs the same mission twice on the virtual clock, then compares the final poses and the flight records
+static void bench_replay(void) {
+    double first_pose[3], second_pose[3];
+    uint64_t first_count, second_count;
+    long mismatch = -1;  // First record that differs (-1 if none)
+
+    bool completed = replay_run(BENCH_REPLAY_FIRST, first_pose);
+    completed = replay_run(BENCH_REPLAY_SECOND, second_pose) && completed;
+    flight_record_t *first = read_recording(BENCH_REPLAY_FIRST, &first_count);
+    flight_record_t *second = read_recording(BENCH_REPLAY_SECOND, &second_count);
+    unlink(BENCH_REPLAY_FIRST);
+    unlink(BENCH_REPLAY_SECOND);
+    if (first == NULL || second == NULL) {
+        fprintf(results, "{\"bench\":\"mission_replay\",\"error\":\"recording\"}\n");
+        free(first);
+        free(second);
+        return;
+    }
+
+    // The sequence numbers count the acquisitions since the start of the bench: compare them from the first record
+    uint64_t count = first_count < second_count ? first_count : second_count;
+    for (uint64_t i = 0; i < count && mismatch < 0; i++) {
+        flight_record_t a = first[i], b = second[i];
+        a.seq -= first[0].seq;
+        b.seq -= second[0].seq;
+        if (memcmp(&a, &b, sizeof(a)) != 0) {
+            mismatch = (long)i;
+        }
+    }
+    if (mismatch < 0 && first_count != second_count) {
+        mismatch = (long)count;
+    }
+    bool same_pose = memcmp(first_pose, second_pose, sizeof(first_pose)) == 0;
+    fprintf(results, "{\"bench\":\"mission_replay\",\"completed\":%s,\"records\":[%llu,%llu],\"same_records\":%s,"
+            "\"first_mismatch\":%ld,\"same_pose\":%s,\"x_mm\":[%.3f,%.3f],\"y_mm\":[%.3f,%.3f],\"theta_rad\":[%.6f,%.6f]}\n",
+            completed ? "true" : "false", (unsigned long long)first_count, (unsigned long long)second_count,
+            mismatch < 0 ? "true" : "false", mismatch, same_pose ? "true" : "false",
+            first_pose[0], second_pose[0], first_pose[1], second_pose[1], first_pose[2], second_pose[2]);
+    fflush(results);
+    free(first);
+    free(second);
+}
+
+int main(void) {
+    // Keep the real stdout for the results and silence the application
+    int fd = dup(STDOUT_FILENO);
+    results = fd >= 0 ? fdopen(fd, "w") : NULL;
+    if (results == NULL || freopen("/dev/null", "w", stdout) == NULL) {
+        fprintf(stderr, "Erreur : impossible de préparer la sortie des résultats.\n");
+        return EXIT_FAILURE;
+    }
+
+    clock_select(&clock_virtual);  // The one of the simulator, whatever MRPIZ_CLOCK says
+    robot_start();
+    bench_status();
+    bench_pilot();
+    bench_wall_following();
+    bench_control_loop();
+    bench_mission_files();
+    bench_mapping();
+    bench_planner();
+    bench_sensor_filter("raw", (sensor_filter_config_t){1, SMOOTHER_NONE, 1.0, 0.0, 0.0, NS_PER_S / CONTROL_RATE_HZ});
+    bench_sensor_filter("ema", (sensor_filter_config_t){1, SMOOTHER_EMA, 0.3, 0.0, 0.0, NS_PER_S / CONTROL_RATE_HZ});
+    bench_sensor_filter("median3", (sensor_filter_config_t){3, SMOOTHER_NONE, 1.0, 0.0, 0.0, NS_PER_S / CONTROL_RATE_HZ});
+    bench_sensor_filter("median3_ema", (sensor_filter_config_t){3, SMOOTHER_EMA, 0.5, 0.0, 0.0, NS_PER_S / CONTROL_RATE_HZ});
+    bench_sensor_filter("default", (sensor_filter_config_t)SENSOR_FILTER_DEFAULT_CONFIG);
+    bench_sensor_filter("median15", (sensor_filter_config_t){15, SMOOTHER_NONE, 1.0, 0.0, 0.0, NS_PER_S / CONTROL_RATE_HZ});
+    const odometry_pose_t open_space = {BENCH_OPEN_X_MM, BENCH_OPEN_Y_MM, 0.0, 0.0};
+    const odometry_pose_t blocked = {BENCH_BLOCKED_X_MM, BENCH_OPEN_Y_MM, 0.0, 0.0};
+    for (int profiled = 0; profiled <= 1; profiled++) {
+        for (int speed = BENCH_MISSION_SPEED; speed <= BENCH_FAST_SPEED; speed += BENCH_FAST_SPEED - BENCH_MISSION_SPEED) {
+            bench_move("move_forward", (move_t){FORWARD, {PATH_DISTANCE, 0}, speed}, 2 * PATH_DISTANCE, profiled, NULL);
+            bench_move("move_forward_long", (move_t){FORWARD, {BENCH_LONG_DISTANCE, 0}, speed},
+                       FORWARD_STEPS_PER_DISTANCE * BENCH_LONG_DISTANCE, profiled, &open_space);
+            bench_move("move_forward_blocked", (move_t){FORWARD, {PATH_DISTANCE, 0}, speed}, 2 * PATH_DISTANCE, profiled, &blocked);
+            bench_move("move_right", (move_t){ROTATION, {RIGHT, 0}, speed}, 200, profiled, NULL);
+            bench_move("move_u_turn", (move_t){ROTATION, {U_TURN, 0}, speed}, 456, profiled, NULL);
+            // Stop-and-go, then blended for the profiled moves (saved_s compares the two)
+            double path1_s = bench_mission("mission_path1", 7, speed, profiled, false, 0.0);
+            double path2_s = bench_mission("mission_path2", 9, speed, profiled, false, 0.0);
+            if (profiled) {
+                bench_mission("mission_path1", 7, speed, true, true, path1_s);
+                bench_mission("mission_path2", 9, speed, true, true, path2_s);
+            }
+        }
+    }
+    bench_replay();
+
+    robot_close();
+    fclose(results);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,120 @@
+/**
+ * @file telemetry_bench.c
+ * @brief Microbenchmark of the telemetry ring enqueue cost.
+ *
+ * Measures telemetry_publish() alone (ring kept drained), then with a
+ * consumer thread draining concurrently as the UI does, and the seqlock
+ * publication of the shared memory segment while a reader thread polls it.
+ */
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "../robot_app/telemetry.h"
+#include "../robot_app/telemetry_shm.h"
+#include "../utils.h"
+
+/** @brief Default number of records published per measurement. */
+#define BENCH_RECORDS 5000000UL
+/** @brief Shared memory segment of the measurement (not the one of a running robot). */
+#define BENCH_SHM_NAME "/mrpiz_telemetry_bench"
+
+static atomic_bool producing;  // true while the producer publishes
+static unsigned long shm_read_failures;  // Reads given up by the reader thread
+
+// Consumer thread: drains the ring as fast as possible
+static void *consumer(void *unused) {
+    telemetry_record_t record;
+    (void)unused;
+    while (atomic_load(&producing)) {
+        while (telemetry_consume(&record)) {
+        }
+    }
+    while (telemetry_consume(&record)) {
+    }
+    return NULL;
+}
+
+// Reader thread: copies the shared state as fast as possible
+static void *shm_reader(void *arg) {
+    const telemetry_shm_segment_t *segment = arg;
+    telemetry_shm_state_t state;
+
+    while (atomic_load(&producing)) {
+        if (!telemetry_shm_read(segment, &state)) {
+            shm_read_failures++;
+        }
+    }
+    return NULL;
+}
+
+// Seqlock publication with a concurrent reader
+static void bench_shm(unsigned long count) {
+    telemetry_shm_state_t state = {0};
+    const telemetry_shm_segment_t *segment;
+    pthread_t thread;
+    uint64_t start, elapsed;
+
+    if (telemetry_shm_open(BENCH_SHM_NAME) != 0 || (segment = telemetry_shm_attach(BENCH_SHM_NAME)) == NULL) {
+        printf("telemetry_shm_publish,unavailable\n");
+        telemetry_shm_close();
+        return;
+    }
+    atomic_store(&producing, true);
+    pthread_create(&thread, NULL, shm_reader, (void *)segment);
+    start = monotonic_ns();
+    for (unsigned long i = 0; i < count; i++) {
+        state.record.step = (int)i;
+        telemetry_shm_publish(&state);
+    }
+    elapsed = monotonic_ns() - start;
+    atomic_store(&producing, false);
+    pthread_join(thread, NULL);
+    printf("telemetry_shm_publish,concurrent_reader,%lu,%.1f ns/op,%lu failed reads\n",
+           count, (double)elapsed / (double)count, shm_read_failures);
+    telemetry_shm_detach(segment);
+    telemetry_shm_close();
+}
+
+int main(int argc, char *argv[]) {
+    unsigned long count = argc > 1 ? strtoul(argv[1], NULL, 10) : BENCH_RECORDS;
+    telemetry_record_t record = {0};
+    telemetry_record_t out;
+    pthread_t thread;
+    uint64_t start, elapsed;
+
+    if (count == 0) {
+        count = BENCH_RECORDS;
+    }
+
+    // Producer alone: publish then consume, so the ring never fills
+    telemetry_reset();
+    start = monotonic_ns();
+    for (unsigned long i = 0; i < count; i++) {
+        record.step = (int)i;
+        telemetry_publish(&record);
+        telemetry_consume(&out);
+    }
+    elapsed = monotonic_ns() - start;
+    printf("telemetry_publish+consume,single_thread,%lu,%.1f ns/op\n",
+           count, (double)elapsed / (double)count);
+
+    // Producer with a concurrent consumer thread
+    telemetry_reset();
+    atomic_store(&producing, true);
+    pthread_create(&thread, NULL, consumer, NULL);
+    start = monotonic_ns();
+    for (unsigned long i = 0; i < count; i++) {
+        record.step = (int)i;
+        telemetry_publish(&record);
+    }
+    elapsed = monotonic_ns() - start;
+    atomic_store(&producing, false);
+    pthread_join(thread, NULL);
+    printf("telemetry_publish,concurrent_consumer,%lu,%.1f ns/op,%lu overflows\n",
+           count, (double)elapsed / (double)count, telemetry_get_overflows());
+
+    bench_shm(count);
+    return EXIT_SUCCESS;
+}
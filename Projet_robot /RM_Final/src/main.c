@@ -1,168 +1,188 @@
-#include <signal.h>   // Gérer les interruptions (ex: Ctrl+C)
-#include <stdio.h>    // Fonctions d'affichage et de lecture (printf, scanf)
+#include <stdbool.h>  // Booléens
+#include <stdio.h>    // Fonctions d'affichage (printf)
 #include <stdlib.h>   // Fonctions utilitaires (exit, malloc)
-#include <unistd.h>   // Fonctions POSIX (sleep, usleep, STDIN_FILENO)
-#include <termios.h>  // Contrôle du terminal (désactiver le mode canonique)
-#include <fcntl.h>    // Manipulation des fichiers et des entrées/sorties
+#include <unistd.h>   // Lecture des options (getopt)
 #include "robot_app/pilot.h"
 #include "robot_app/robot.h"
 #include "utils.h"
 #include "robot_app/copilot.h"
 #include "robot_app/app_manager.h"
 #include "robot_app/IHM.h"
-
-// Definition of process states (active or stopped)
-typedef enum {
-    STOPPED = 0, // The process is stopped
-    ALIVE        // The process is running
-} process_state_t;
-
-// Global variable to track the program state
-static process_state_t running = ALIVE;
-
-// Save initial terminal settings
-static struct termios saved_tattr;
-
-// SIGINT (Ctrl+C) signal handler to gracefully stop the program
-static void sigint_handler(int dummy) {
-    running = STOPPED;
-}
-
-// Configure the terminal in non-canonical mode for user input
-void set_input_mode(void) {
-    struct termios tattr;
-
-    // Save current terminal attributes
-    tcgetattr(STDIN_FILENO, &saved_tattr);
-
-    // Disable canonical mode and input echo
-    tcgetattr(STDIN_FILENO, &tattr);
-    tattr.c_lflag &= ~(ICANON | ECHO);
-
-    // Apply the new terminal configuration
-    tcsetattr(STDIN_FILENO, TCSANOW, &tattr);
-}
-
-// Restore initial terminal settings before exiting
-void restore_input_mode(void) {
-    tcsetattr(STDIN_FILENO, TCSANOW, &saved_tattr);
+#include "robot_app/control_loop.h"
+#include "robot_app/event_loop.h"
+#include "robot_app/fleet.h"
+#include "robot_app/flight_recorder.h"
+#include "robot_app/link_stats.h"
+#include "robot_app/logger.h"
+#include "robot_app/speed_ctrl.h"
+#include "robot_app/telemetry_shm.h"
+
+/** @brief Period of the display timer while a path runs (in nanoseconds). */
+#define DISPLAY_PERIOD_NS (DELAY * 1000ULL)
+
+// Convert a key to a digit
+static int key_digit(int key) {
+    if (key < '0' || key > '9') return -1; // Not a digit
+    return key - '0';
 }
 
-// Read user input and convert to integer
-int get_input() {
-    char c;
-    c = getchar();
-    if (c < '0' || c > '9') return -1; // Return an error for invalid input
-    return c - '0';// Convert character to integer
+// Enter a state: show its prompt and arm the display timer if it needs one
+static app_state_t enter_state(app_state_t state) {
+    switch (state) {
+        case STATE_SELECT_PATH:
+            display_menu(); // Display user menu
+            break;
+        case STATE_SELECT_SPEED:
+            printf("Choisissez la vitesse (1-10) : ");
+            break;
+        case STATE_FOLLOW_WALL:
+            printf("Mode suivi du mur droit activé. Appuyez sur 't' pour arrêter.\n");
+            break;
+        default:
+            break;
+    }
+    fflush(stdout);
+    event_loop_set_timer(state == STATE_EXECUTE_PATH ? DISPLAY_PERIOD_NS : 0);
+    return state;
 }
 
-int is_t_pressed(void) {
-    struct termios oldt, newt;
-    int ch;
-    int oldf;
+// Start the selected path at the chosen speed
+static app_state_t start_path(int path_choice, int speed) {
+    const path_t *selected_path;
 
-    // Get the current terminal settings
-    tcgetattr(STDIN_FILENO, &oldt);
-    newt = oldt;
-    newt.c_lflag &= ~(ICANON | ECHO);
-    tcsetattr(STDIN_FILENO, TCSANOW, &newt);
-    
-    // Set stdin to non-blocking mode
-    oldf = fcntl(STDIN_FILENO, F_GETFL, 0);
-    fcntl(STDIN_FILENO, F_SETFL, oldf | O_NONBLOCK);
-
-    // Try to read a character
-    ch = getchar();
-
-    // Restore terminal settings
-    tcsetattr(STDIN_FILENO, TCSANOW, &oldt);
-    fcntl(STDIN_FILENO, F_SETFL, oldf);
+    clear_screen();
+    // Retrieve selected path
+    selected_path = get_path(path_choice);
+    if (selected_path == NULL) {
+        printf("Choix de chemin invalide.\n");
+        return enter_state(STATE_SELECT_PATH);
+    }
 
-    if (ch == 't' || ch == 'T') {
-        return 1; // 't' key was pressed
+    // Start the selected path
+    copilot_set_path(selected_path->moves, selected_path->steps);
+    copilot_set_speed(speed);
+    copilot_start_path();
+    if (start_path_execution() != 0) {
+        speed_ctrl_set_target(0, 0);
+        return enter_state(STATE_SELECT_PATH);
     }
-    return 0; // No 't' key was pressed
+    return enter_state(STATE_EXECUTE_PATH);
 }
 
-// Main application loop managing different states
+// Main application loop: every state waits for its events in the same poll()
 void app_loop() {
-    robot_status_t my_status;
-    app_state_t state = STATE_SELECT_PATH;
-    int path_choice, speed;
-    move_t *selected_path = NULL;
-    int selected_steps = 0;
-
-    set_input_mode(); // Configure terminal
+    app_state_t state = enter_state(STATE_SELECT_PATH);
+    int path_choice = 0;
+    bool running = true;
 
     while (running) {
+        event_t event = event_loop_wait();
+
+        if (event.type == EVENT_QUIT) { // Ctrl+C, or the end of the input
+            running = false;
+            break;
+        }
+
         switch (state) {
             case STATE_SELECT_PATH:
-                display_menu(); // Display user menu
-               
-                path_choice = get_input();
+                if (event.type != EVENT_KEY || key_digit(event.key) < 0) {
+                    break; // Only a digit chooses
+                }
+                path_choice = key_digit(event.key);
                 if (path_choice == 0) { // Exit application
-                    running = STOPPED;
-                    break;
+                    running = false;
                 }
                 else if (path_choice == 1) { // Wall-following mode
-                    printf("Mode suivi du mur droit activé.\n");
-                    state = STATE_FOLLOW_WALL;
-                } else {
-                    printf("Choisissez la vitesse (1-10) : ");
-                    speed = get_input() * 10;
-                    clear_screen();
-                    // Retrieve selected path
-                    selected_path = get_path(path_choice, &selected_steps, speed);
-                    if (selected_path == NULL) {
-                        printf("Choix de chemin invalide.\n");
-                        continue;
+                    if (start_wall_following() != 0) {
+                        state = enter_state(STATE_SELECT_PATH);
+                    } else {
+                        state = enter_state(STATE_FOLLOW_WALL);
                     }
-                    
-                    // Start the selected path
-                    copilot_set_path(selected_path, selected_steps);
-                    copilot_start_path();
-                    state = STATE_EXECUTE_PATH;
+                } else {
+                    state = enter_state(STATE_SELECT_SPEED);
+                }
+                break;
+
+            case STATE_SELECT_SPEED:
+                if (event.type == EVENT_KEY && key_digit(event.key) >= 0) {
+                    state = start_path(path_choice, key_digit(event.key) * 10);
                 }
                 break;
 
             case STATE_EXECUTE_PATH:
-                my_status = robot_get_status(); // Get robot status
-                display_robot_status(my_status);
-                
+                // The control loop drives the path: only observe it, on each timer expiry
+                if (event.type != EVENT_TIMER) {
+                    break;
+                }
+                display_telemetry();
+
                 // Check if movement is completed
-                if (check_path_completion() || pilot_get_status() == MOVE_DONE) {
-                    state = STATE_CHECK_COMPLETION;
+                if (check_path_completion()) {
+                    printf("Chemin terminé. Choisissez un autre chemin ou quittez.\n");
+                    state = enter_state(STATE_SELECT_PATH);
                 }
                 break;
-            
-            case STATE_CHECK_COMPLETION:
-                printf("Chemin terminé. Choisissez un autre chemin ou quittez.\n");
-                state = STATE_SELECT_PATH;
-                break;
 
             case STATE_FOLLOW_WALL:
-                printf("Mode suivi du mur droit activé. Appuyez sur 't' pour arrêter.\n");
-                while (running && !is_t_pressed()) {
-                    follow_right_wall();
-                    usleep(100000); // Pause pour éviter une surcharge du CPU
+                // The control loop drives the robot: only watch the keyboard
+                if (event.type == EVENT_KEY && (event.key == 't' || event.key == 'T')) {
+                    printf("Vous passez en mode manuel.\n");
+                    stop_wall_following();  // Stop the robot
+                    state = enter_state(STATE_SELECT_PATH);
                 }
-                printf("Vous passez en mode manuel.\n");
-                robot_set_speed(0, 0);  // Stop the robot         /*ajout*/
-                state = STATE_SELECT_PATH;
-            break;
+                break;
 
             default:
                 fprintf(stderr, "Erreur inconnue.\n");
                 break;
             }
     }
+    control_loop_stop(); // Interrupted while a path was running
 }
 
 // Main function of the program
-int main(void) {
+int main(int argc, char *argv[]) {
+    fleet_config_t fleet = FLEET_DEFAULT_CONFIG;
+    const char *mission_path;
+    int opt;
+
+    // Options of the fleet mode, then the mission file
+    while ((opt = getopt(argc, argv, "f:a:p:c:v:m:t:")) != -1) {
+        switch (opt) {
+            case 'f': fleet.robots = atoi(optarg); break;
+            case 'a': fleet.address = optarg; break;
+            case 'p': fleet.base_port = atoi(optarg); break;
+            case 'c': fleet.path_choice = atoi(optarg); break;
+            case 'v': fleet.speed = atoi(optarg); break;
+            case 'm': fleet.missions = strtoul(optarg, NULL, 10); break;
+            case 't': fleet.mission_timeout_ns = strtoull(optarg, NULL, 10) * NS_PER_S; break;
+            default:
+                fprintf(stderr, "Usage : %s [-f robots [-a adresse] [-p premier_port] [-c chemin] [-v vitesse] [-m missions] [-t délai_s]] [mission]\n",
+                        argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+    mission_path = optind < argc ? argv[optind] : NULL;
+    if (fleet.robots > 0) {
+        return fleet_run(&fleet, mission_path) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    // Before any thread is created, so that Ctrl+C is only read by the event loop
+    if (event_loop_open() != 0) {
+        printf("Erreur lors de l'ouverture de la boucle d'événements.\n");
+        return EXIT_FAILURE;
+    }
+
+    // Messages of the pilot and the copilot, written by a background thread
+    if (logger_open() != 0) {
+        printf("Journal désactivé.\n");
+    }
+
     if (robot_start()) { // Initialize robot
         printf("Erreur lors du démarrage du simulateur de robot.\n");
         fflush(stdout);
+        logger_close();
+        event_loop_close();
         return EXIT_FAILURE;
     }
     
@@ -170,13 +190,43 @@ int main(void) {
     printf("Ctrl+C pour quitter\n");
     fflush(stdout);
 
-    // Associate SIGINT signal with sigint_handler
-    signal(SIGINT, sigint_handler);
+    // Mission file given on the command line, checked now and read again on each selection
+    if (mission_path != NULL && load_mission(mission_path) != 0) {
+        printf("Mission %s non chargée.\n", mission_path);
+    }
+
+    // Record the control loop ticks (the application still runs without it)
+    if (flight_recorder_open(FLIGHT_RECORDER_DEFAULT_PATH, FLIGHT_RECORDER_DEFAULT_CAPACITY) != 0) {
+        printf("Enregistreur de vol désactivé.\n");
+    }
+
+    // Live state for the external readers (tools/robot_watch)
+    if (telemetry_shm_open(NULL) != 0) {
+        printf("Télémétrie partagée %s désactivée.\n", telemetry_shm_default_name());
+    }
 
     app_loop(); // Start main loop
 
-    restore_input_mode(); // Restore terminal settings
+    telemetry_shm_close();
+    flight_recorder_close();
+    logger_close(); // Write the last messages
+    if (logger_get_dropped() > 0) {
+        printf("Journal : %lu messages perdus\n", logger_get_dropped());
+    }
+
+    // Report how much link traffic the status snapshot saved
+    robot_snapshot_stats_t stats = robot_get_snapshot_stats();
+    printf("Snapshot : %lu acquisitions, %lu lectures, %lu appels mrpiz évités\n",
+           stats.acquisitions, stats.reads, stats.link_calls_avoided);
+
+    // And how much the actuator cache saved
+    robot_command_stats_t commands = robot_get_command_stats();
+    printf("Commandes : %lu consignes (%lu regroupées, %lu arrêts immédiats), %lu appels moteur, %lu évités, %lu appels LED évités\n",
+           commands.speed_requests, commands.coalesced, commands.immediate_stops,
+           commands.motor_calls, commands.motor_calls_saved, commands.led_calls_saved);
 
     robot_close(); // Properly shut down the robot
+    link_stats_print();
+    event_loop_close(); // Restore terminal settings, last so a second Ctrl+C cannot skip the stop
     return EXIT_SUCCESS;
 }
@@ -21,6 +21,8 @@ void display_menu() {
     printf("* 5. Path definie (7)              *\n");  // Predefined path 1
     printf("* 6. Path definie (9)              *\n");  // Predefined path 2
     printf("* 7 - Suivi du mur droit(1)        *\n");  // Follow right wall
+    printf("* 8. Mission du fichier (5)        *\n");  // Mission loaded from a file
+    printf("* 9. Retour au départ (3)          *\n");  // Planned return to the start pose
     printf("* 0. Quitter                       *\n");  // Quit the application
     printf("************************************\n");
     printf("Choisissez une option : ");  // Prompt user to choose an option
@@ -1,87 +1,203 @@
 #include "app_manager.h"
+#include "control_loop.h"
+#include "telemetry.h"
+#include "telemetry_shm.h"
+#include "flight_recorder.h"
+#include "speed_ctrl.h"
+#include "odometry.h"
+#include "occupancy_grid.h"
+#include "planner.h"
+#include "obstacle_model.h"
+#include "../utils.h"
+#include <math.h>
 #include <stdio.h>
-#include <unistd.h>
-
-// Arrays to store different paths
-move_t path1[STEPS_NUMBER];
-move_t path2[STEPS_NUMBER];
-move_t path3[1];
-move_t path4[1];
-move_t path5[1];
-move_t path6[1];
-
-// Function to initialize paths with given speed
-void initialize_paths(int speed) {
-    
-    for (int i = 0; i < STEPS_NUMBER; i++) {
-        path1[i] = (move_t){FORWARD, {DISTANCE, 0}, speed};
-        path2[i] = (move_t){FORWARD, {DISTANCE, 0}, speed};
-        if (i % 2 == 1) {
-            
-            path1[i].direction = ROTATION;
-            path2[i].direction = ROTATION;
-            path1[i].parameters[0] = (i % 4 == 1) ? RIGHT : LEFT;
-            path2[i].parameters[0] = (i % 4 == 1) ? RIGHT : LEFT;
-        }
-    }
-    path3[0] = (move_t){FORWARD, {DISTANCE, 0}, speed};
-    path4[0] = (move_t){ROTATION, {RIGHT, 0}, speed};
-    path5[0] = (move_t){ROTATION, {LEFT, 0}, speed};
-    path6[0] = (move_t){ROTATION, {U_TURN, 0}, speed};
-}
 
-// Function to get the path based on the user's choice
-move_t* get_path(int path_choice, int *steps, int speed) {
+static const char *mission_file = NULL;  // Mission file of MISSION_CHOICE (NULL if none)
+static mission_t mission;  // Mission loaded from mission_file
+static path_t return_path;  // Path planned by RETURN_CHOICE
+static uint64_t last_acquisition_ns;  // Acquisition time of the previous tick (0 at the start of a run)
 
-    robot_status_t status = robot_get_status();  // Get the current status of the robot
+// Function to load the mission file selected with MISSION_CHOICE
+int load_mission(const char *filename) {
+    mission_unload(&mission);
+    mission_file = filename;
+    return mission_load(filename, &mission);
+}
 
-    // Check if the path is clear based on sensor readings
-    int front_clear = status.center_sensor > OBSTACLE_DISTANCE_THRESHOLD;
+// Function to get the path based on the user's choice
+const path_t *get_path(int path_choice) {
+    path_id_t id;
 
-    initialize_paths(speed);  // Initialize paths with the given speed
     switch (path_choice) {
-        case 7:
-            *steps = STEPS_NUMBER;
-            return path1;
-        case 9:
-            *steps = STEPS_NUMBER;
-            return path2;
-        case 8:
-            if (front_clear ) {
-                *steps = 1;
-                return path3;
-            } else {
+        case MISSION_CHOICE:
+            if (mission_file == NULL || load_mission(mission_file) != 0) {
+                return NULL;
+            }
+            return &mission.path;
+        case RETURN_CHOICE: {
+            odometry_pose_t pose = odometry_get_pose();
+            if (planner_plan_path(&pose, 0.0, 0.0, &return_path) != 0 || return_path.steps == 0) {
                 return NULL;
             }
-        case 6:
-            *steps = 1;
-            return path4;
-        case 4:
-            *steps = 1;
-            return path5;
-        case 2:
-            *steps = 1;
-            return path6;
-        default:
+            return &return_path;
+        }
+        case 7: id = PATH_ID_1; break;
+        case 9: id = PATH_ID_2; break;
+        case 8: id = PATH_ID_FORWARD; break;
+        case 6: id = PATH_ID_RIGHT; break;
+        case 4: id = PATH_ID_LEFT; break;
+        case 2: id = PATH_ID_U_TURN; break;
+        default: return NULL;
+    }
+
+    if (id == PATH_ID_FORWARD) {
+        robot_refresh_status();  // Selection happens outside of a control tick
+        // Check if the path is clear based on sensor readings
+        obstacle_model_t obstacles = obstacle_model_get();
+        if (!obstacle_model_can_advance(&obstacles, PATH_DISTANCE * FORWARD_STEPS_PER_DISTANCE * ODOMETRY_MM_PER_STEP)) {
             return NULL;
+        }
     }
+    return path_registry_get(id);
 }
 
 // Function to display the robot's status
 void display_robot_status(robot_status_t status) {
     fprintf(stdout, "Encoders: left = %d, right = %d\n", status.left_encoder, status.right_encoder);
-    fprintf(stdout, "Proximity sensors: left = %d, center = %d, right = %d\n", status.left_sensor, status.center_sensor, status.right_sensor);
+    fprintf(stdout, "Proximity sensors: left = %d, center left = %d, center = %d, center right = %d, right = %d\n",
+            status.sensors[SENSOR_LEFT], status.sensors[SENSOR_CENTER_LEFT], status.sensors[SENSOR_CENTER],
+            status.sensors[SENSOR_CENTER_RIGHT], status.sensors[SENSOR_RIGHT]);
     fprintf(stdout, "Battery: %d%%\n", status.battery);
 }
 
+// Publishes the state of the current tick for the UI and the flight recorder
+static void publish_telemetry(path_status_t path_status) {
+    speed_pct_t left_speed, right_speed;
+    telemetry_record_t record = {
+        .snapshot = robot_get_snapshot(),
+        .pose = odometry_get_pose(),
+        .move_status = pilot_get_status(),
+        .path_status = path_status,
+        .step = copilot_get_current_step(),
+        .publish_ns = monotonic_ns()
+    };
+    telemetry_publish(&record);  // Never waits: dropped if the UI lags
+
+    robot_get_commanded_speed(&left_speed, &right_speed);
+    flight_recorder_log(&record, left_speed, right_speed);
+
+    // Latest state for the external readers, who never hold back the loop
+    telemetry_shm_state_t live = {
+        .record = record,
+        .left_speed = left_speed,
+        .right_speed = right_speed,
+        .loop = control_loop_get_stats()
+    };
+    telemetry_shm_publish(&live);
+}
+
+// Measures the time since the acquisition of the previous tick, on the robot clock:
+// a late wake-up lengthens it, so the odometry and the speed correction see the true period
+static uint64_t measure_tick_period(void) {
+    uint64_t now = robot_get_snapshot().timestamp_ns;
+    uint64_t period = NS_PER_S / CONTROL_RATE_HZ;  // First tick of a run: nothing to measure yet
+
+    if (last_acquisition_ns != 0 && now > last_acquisition_ns) {
+        period = now - last_acquisition_ns;
+    }
+    last_acquisition_ns = now;
+    return period;
+}
+
+// Control tick: one acquisition and the map, one copilot step, then the wheel speed correction,
+// whose commands reach the link once, at the end of the tick
+static int path_tick(void *unused) {
+    (void)unused;
+    robot_hold_commands();
+    robot_refresh_status();
+    uint64_t period = measure_tick_period();
+    odometry_update(period);
+    occupancy_grid_update();
+    path_status_t path_status = copilot_stop_at_step_completion();
+    speed_ctrl_update(period);
+    robot_flush_commands();
+    publish_telemetry(path_status);
+    return path_status != PATH_IN_PROGRESS;
+}
+
+// Function to start the control loop along the current path
+int start_path_execution(void) {
+    control_loop_config_t config = {CONTROL_RATE_HZ, CONTROL_REALTIME, CONTROL_PRIORITY};
+    telemetry_reset();
+    speed_ctrl_reset_stats();
+    last_acquisition_ns = 0;
+    return control_loop_start(&config, path_tick, NULL);
+}
+
+// Control tick: one acquisition and the map, one wall-following step, then the wheel speed correction,
+// whose commands reach the link once, at the end of the tick
+static int wall_tick(void *unused) {
+    (void)unused;
+    robot_hold_commands();
+    robot_refresh_status();
+    uint64_t period = measure_tick_period();
+    odometry_update(period);
+    occupancy_grid_update();
+    follow_right_wall();
+    speed_ctrl_update(period);
+    robot_flush_commands();
+    publish_telemetry(PATH_NOT_STARTED);
+    return 0;
+}
+
+// Function to start the control loop ticking the wall follower
+int start_wall_following(void) {
+    control_loop_config_t config = {CONTROL_RATE_HZ, CONTROL_REALTIME, CONTROL_PRIORITY};
+    pilot_reset_wall_following();
+    telemetry_reset();
+    speed_ctrl_reset_stats();
+    last_acquisition_ns = 0;
+    return control_loop_start(&config, wall_tick, NULL);
+}
+
+// Function to stop the wall follower and the robot
+void stop_wall_following(void) {
+    control_loop_stop();
+    speed_ctrl_set_target(0, 0);  // Stop the robot
+    control_loop_print_stats();
+    speed_ctrl_print_stats();
+    occupancy_grid_print_stats();
+}
+
+// Function to display the newest telemetry record
+void display_telemetry(void) {
+    telemetry_record_t latest;
+
+    if (telemetry_drain_latest(&latest) == 0) {
+        return;  // Nothing new since the last refresh
+    }
+    fprintf(stdout, "Étape %d, mouvement %d, chemin %d (tick %u)\n",
+            latest.step, latest.move_status, latest.path_status, (unsigned)latest.snapshot.seq);
+    fprintf(stdout, "Pose: x = %.0f mm, y = %.0f mm, cap = %.1f deg, v = %.0f mm/s\n",
+            latest.pose.x_mm, latest.pose.y_mm, latest.pose.theta_rad * 180.0 / M_PI, latest.pose.v_mm_s);
+    display_robot_status(latest.snapshot.status);
+}
+
 // Function to check if the path execution is completed
 int check_path_completion(void) {
-    for (int i = 0; i < ENCODERS_SCAN_NB; i++) {
-        usleep(DELAY);  // Wait for a specified delay
-        if (copilot_stop_at_step_completion() == PATH_COMPLETED) {
-            printf("All steps completed.\n");
-            return 1;
-        }
+    if (control_loop_is_running()) {
+        return 0;
+    }
+    control_loop_stop();  // Join the ended control thread
+    if (copilot_is_path_completed()) {
+        printf("All steps completed.\n");
+    } else {
+        printf("Chemin abandonné à l'étape %d.\n", copilot_get_current_step());
     }
-    return copilot_is_path_completed();
+    printf("Transitions sans arrêt : %d\n", copilot_get_blend_count());
+    control_loop_print_stats();
+    speed_ctrl_print_stats();
+    occupancy_grid_print_stats();
+    printf("Télémétrie : %lu enregistrements perdus\n", telemetry_get_overflows());
+    return 1;
 }
\ No newline at end of file
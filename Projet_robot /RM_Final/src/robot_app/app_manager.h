@@ -1,20 +1,23 @@
 #ifndef APP_MANAGER_H
 #define APP_MANAGER_H
 
+#include "control_loop.h"
 #include "pilot.h"
 #include "robot.h"
 #include "copilot.h"
+#include "path_registry.h"
+#include "mission.h"
 
-/** @brief Number of steps (or moves) in the path. */
-#define STEPS_NUMBER 12
-/** @brief Waiting time between two encoder scans (in microseconds). So 10 000 for 2D and 1 000 000 for 3D */
+/** @brief Refresh period of the status display while a path runs (in microseconds). */
 #define DELAY 100000
-/** @brief Maximum number of attempts to check if a move is finished. */
-#define ENCODERS_SCAN_NB 1000
-/** @brief Distance for each move. */
-#define DISTANCE 100
-/** @brief Obstacle distance threshold. */
-#define OBSTACLE_DISTANCE_THRESHOLD 50
+/** @brief Run the control loop under SCHED_FIFO when the process is allowed to. */
+#define CONTROL_REALTIME true
+/** @brief SCHED_FIFO priority of the control loop. */
+#define CONTROL_PRIORITY 50
+/** @brief Menu key of the mission loaded from a file. */
+#define MISSION_CHOICE 5
+/** @brief Menu key of the planned return to the start pose. */
+#define RETURN_CHOICE 3
 
 /**
  * @enum app_state_t
@@ -22,27 +25,41 @@
  */
 typedef enum {
     STATE_SELECT_PATH,     /**< State for selecting the path. */
+    STATE_SELECT_SPEED,    /**< State for selecting the speed of the path. */
     STATE_EXECUTE_PATH,    /**< State for executing the path. */
-    STATE_CHECK_COMPLETION,/**< State for checking path completion. */
     STATE_FOLLOW_WALL      /**< State for following the wall. */
 } app_state_t;
 
 /**
- * @brief Initializes the paths with the given speed.
- * 
- * @param speed The speed to set for the paths.
+ * @brief Loads the mission file selected with MISSION_CHOICE.
+ *
+ * The previous mission is released: no path may be running.
+ *
+ * @param filename The mission file, kept until the next call.
+ * @return 0 on success, -1 if the mission is invalid.
  */
-void initialize_paths(int speed);
+int load_mission(const char *filename);
 
 /**
  * @brief Gets the path based on the user's choice.
- * 
- * @param path_choice The chosen path.
- * @param steps Pointer to store the number of steps in the path.
- * @param speed The speed to set for the path.
- * @return Pointer to the chosen path.
+ *
+ * The forward path is only given if the way ahead is clear. The mission
+ * file is read again on each MISSION_CHOICE, so it can be edited between
+ * two runs. The return to the start is planned on the occupancy grid,
+ * from the estimated pose.
+ *
+ * @param path_choice The chosen path (menu key).
+ * @return The chosen path from the registry, NULL if none.
+ */
+const path_t *get_path(int path_choice);
+
+/**
+ * @brief Displays the latest telemetry published by the control loop.
+ *
+ * Drains the telemetry ring and shows only the newest record, so a slow
+ * terminal never holds back the control loop.
  */
-move_t* get_path(int path_choice, int *steps, int speed);
+void display_telemetry(void);
 
 /**
  * @brief Displays the robot's status.
@@ -52,9 +69,34 @@ move_t* get_path(int path_choice, int *steps, int speed);
 void display_robot_status(robot_status_t status);
 
 /**
- * @brief Checks if the path execution is completed.
- * 
- * @return 1 if the path is completed, 0 otherwise.
+ * @brief Starts the control loop that drives the copilot along the current path.
+ *
+ * The path must have been set and started with the copilot beforehand.
+ *
+ * @return 0 on success, -1 if the control loop cannot start.
+ */
+int start_path_execution(void);
+
+/**
+ * @brief Starts the control loop that ticks the right wall follower.
+ *
+ * The loop runs until stop_wall_following() is called.
+ *
+ * @return 0 on success, -1 if the control loop cannot start.
+ */
+int start_wall_following(void);
+
+/**
+ * @brief Stops the wall follower control loop and the robot.
+ */
+void stop_wall_following(void);
+
+/**
+ * @brief Checks if the path execution is completed, without blocking.
+ *
+ * Once the control loop has ended, it is joined and its statistics are printed.
+ *
+ * @return 1 if the path execution has ended, 0 while it is still running.
  */
 int check_path_completion(void);
 
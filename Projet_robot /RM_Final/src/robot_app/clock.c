@@ -0,0 +1,123 @@
+#include "clock.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../utils.h"
+#ifdef MRPIZ_SIM
+#include "../backend/mrpiz_sim.h"
+#endif
+
+static const clock_source_t *selected;                 // Selected clock (NULL until the first use)
+static pthread_once_t select_once = PTHREAD_ONCE_INIT; // Selection from the environment
+#ifdef MRPIZ_SIM
+static uint64_t sim_last_wake_ns;                      // Monotonic time up to which the simulator was advanced (real clock)
+#else
+static pthread_mutex_t virtual_lock = PTHREAD_MUTEX_INITIALIZER; // Protects virtual_ns
+static uint64_t virtual_ns;                            // Virtual time
+#endif
+
+// Sleeps until an absolute monotonic deadline
+static void real_sleep_until_ns(uint64_t deadline) {
+    struct timespec ts = {
+        .tv_sec = (time_t)(deadline / NS_PER_S),
+        .tv_nsec = (long)(deadline % NS_PER_S)
+    };
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) != 0) {
+        // Interrupted by a signal: sleep again until the same deadline
+    }
+#ifdef MRPIZ_SIM
+    // The simulated world follows the real time (only the control thread sleeps)
+    uint64_t now = monotonic_ns();
+    if (sim_last_wake_ns != 0 && now > sim_last_wake_ns) {
+        mrpiz_sim_advance_ns(now - sim_last_wake_ns);
+    }
+    sim_last_wake_ns = now;
+#endif
+}
+
+#ifdef MRPIZ_SIM
+
+// The virtual time is the one of the native simulator
+static uint64_t virtual_now_ns(void) {
+    return mrpiz_sim_now_ns();
+}
+
+// Advances the simulator up to the deadline instead of sleeping
+static void virtual_sleep_until_ns(uint64_t deadline) {
+    uint64_t now = mrpiz_sim_now_ns();
+    if (deadline > now) {
+        mrpiz_sim_advance_ns(deadline - now);
+    }
+}
+
+#else
+
+// Gets the virtual time
+static uint64_t virtual_now_ns(void) {
+    pthread_mutex_lock(&virtual_lock);
+    uint64_t now = virtual_ns;
+    pthread_mutex_unlock(&virtual_lock);
+    return now;
+}
+
+// Jumps to the deadline instead of sleeping
+static void virtual_sleep_until_ns(uint64_t deadline) {
+    pthread_mutex_lock(&virtual_lock);
+    if (deadline > virtual_ns) {
+        virtual_ns = deadline;
+    }
+    pthread_mutex_unlock(&virtual_lock);
+}
+
+#endif // MRPIZ_SIM
+
+const clock_source_t clock_real = {"real", monotonic_ns, real_sleep_until_ns};
+const clock_source_t clock_virtual = {"virtual", virtual_now_ns, virtual_sleep_until_ns};
+
+// Selects the clock named in the environment
+static void select_from_env(void) {
+    const char *name = getenv(CLOCK_SOURCE_ENV);
+
+    if (name != NULL && strcmp(name, clock_real.name) == 0) {
+        selected = &clock_real;
+    } else if (name != NULL && strcmp(name, clock_virtual.name) == 0) {
+        selected = &clock_virtual;
+    } else {
+#ifdef MRPIZ_SIM
+        selected = &clock_virtual;
+#else
+        selected = &clock_real;
+#endif
+    }
+}
+
+// Gets the selected clock
+const clock_source_t *clock_get(void) {
+    pthread_once(&select_once, select_from_env);
+    return selected;
+}
+
+// Selects the clock before any timed thread is started
+void clock_select(const clock_source_t *source) {
+    pthread_once(&select_once, select_from_env);
+    if (source != NULL) {
+        selected = source;
+    }
+}
+
+// Gets the time of the selected clock
+uint64_t clock_now_ns(void) {
+    return clock_get()->now_ns();
+}
+
+// Waits until the selected clock reaches a deadline
+void clock_sleep_until_ns(uint64_t deadline) {
+    clock_get()->sleep_until_ns(deadline);
+}
+
+// Waits for a duration of the selected clock
+void clock_sleep_ns(uint64_t duration) {
+    const clock_source_t *source = clock_get();
+    source->sleep_until_ns(source->now_ns() + duration);
+}
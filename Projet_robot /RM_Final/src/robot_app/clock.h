@@ -0,0 +1,81 @@
+#ifndef CLOCK_H
+#define CLOCK_H
+
+#include <stdint.h>
+
+/**
+ * @file clock.h
+ * @brief Time source of the control loop and of the missions: real or virtual.
+ *
+ * Every timed wait of the robot goes through the selected clock:
+ * - the real clock reads CLOCK_MONOTONIC and sleeps for real,
+ * - the virtual clock jumps to the deadline at once: with a local backend,
+ *   a one-hour mission runs in seconds, tick after tick, and two runs give
+ *   the same results.
+ *
+ * With the native simulator (MRPIZ_SIM), the virtual clock is the one of the
+ * simulator, whose world moves while the clock advances; the real clock
+ * advances the simulator as the time goes by, to watch a mission at its
+ * true pace.
+ *
+ * The clock is selected once, by CLOCK_SOURCE_ENV ("real" or "virtual"):
+ * the virtual clock by default with the native simulator, the real clock
+ * otherwise. The acquisitions, and so the flight records, are timestamped
+ * on this clock; the logs and the published states stay on the monotonic
+ * clock, since they tell their readers how fresh they are.
+ */
+
+/** @brief Environment variable selecting the clock ("real" or "virtual"). */
+#define CLOCK_SOURCE_ENV "MRPIZ_CLOCK"
+
+/**
+ * @struct clock_source_t
+ * @brief Implementation of a clock.
+ */
+typedef struct {
+    const char *name;                          /**< "real" or "virtual" */
+    uint64_t (*now_ns)(void);                  /**< Current time (in nanoseconds) */
+    void (*sleep_until_ns)(uint64_t deadline); /**< Returns once the time has reached the deadline */
+} clock_source_t;
+
+/** @brief CLOCK_MONOTONIC, real sleeps. */
+extern const clock_source_t clock_real;
+/** @brief Time that jumps to each deadline. */
+extern const clock_source_t clock_virtual;
+
+/**
+ * @brief Gets the selected clock, selecting it on the first call.
+ *
+ * @return The clock.
+ */
+const clock_source_t *clock_get(void);
+
+/**
+ * @brief Selects the clock, before any timed thread is started.
+ *
+ * @param source The clock (NULL for the one chosen by CLOCK_SOURCE_ENV).
+ */
+void clock_select(const clock_source_t *source);
+
+/**
+ * @brief Gets the time of the selected clock.
+ *
+ * @return The time in nanoseconds.
+ */
+uint64_t clock_now_ns(void);
+
+/**
+ * @brief Waits until the selected clock reaches a deadline.
+ *
+ * @param deadline Absolute time in nanoseconds (past deadlines return at once).
+ */
+void clock_sleep_until_ns(uint64_t deadline);
+
+/**
+ * @brief Waits for a duration of the selected clock.
+ *
+ * @param duration Duration in nanoseconds.
+ */
+void clock_sleep_ns(uint64_t duration);
+
+#endif // CLOCK_H
@@ -0,0 +1,159 @@
+#include "control_loop.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+#include "clock.h"
+#include "../utils.h"
+
+static pthread_t thread;                           // Control thread
+static pthread_mutex_t stats_lock = PTHREAD_MUTEX_INITIALIZER; // Protects stats
+static control_loop_stats_t stats;                 // Timing statistics
+static uint64_t jitter_sum_ns;                     // Sum of the wake-up latencies
+static atomic_bool running = false;                // true while the thread ticks
+static atomic_bool stop_requested = false;         // Set to end the loop
+static bool started = false;                       // true until the thread is joined
+static control_tick_t tick_fn;                     // Function called on every tick
+static void *tick_arg;                             // Argument of the tick function
+
+// Updates the statistics after one tick
+static void record_tick(uint64_t deadline, uint64_t wake, uint64_t previous_wake, uint64_t end) {
+    uint64_t jitter = wake > deadline ? wake - deadline : 0;
+    uint64_t duration = end - wake;
+
+    pthread_mutex_lock(&stats_lock);
+    stats.ticks++;
+    if (previous_wake != 0) {
+        uint64_t period = wake - previous_wake;
+        if (stats.min_period_ns == 0 || period < stats.min_period_ns) stats.min_period_ns = period;
+        if (period > stats.max_period_ns) stats.max_period_ns = period;
+    }
+    if (jitter > stats.max_jitter_ns) stats.max_jitter_ns = jitter;
+    jitter_sum_ns += jitter;
+    stats.mean_jitter_ns = jitter_sum_ns / stats.ticks;
+    if (duration > stats.max_tick_ns) stats.max_tick_ns = duration;
+    pthread_mutex_unlock(&stats_lock);
+}
+
+// Body of the control thread
+static void *control_thread(void *unused) {
+    (void)unused;
+    uint64_t period = stats.period_ns;
+    uint64_t deadline = clock_now_ns() + period;
+    uint64_t previous_wake = 0;
+
+    while (!atomic_load(&stop_requested)) {
+        clock_sleep_until_ns(deadline);
+        uint64_t wake = clock_now_ns();
+
+        int end_requested = tick_fn(tick_arg);
+
+        uint64_t end = clock_now_ns();
+        record_tick(deadline, wake, previous_wake, end);
+        previous_wake = wake;
+        if (end_requested) {
+            break;
+        }
+
+        deadline += period;
+        if (end > deadline) {
+            // The tick missed its next deadline: skip the lost periods
+            pthread_mutex_lock(&stats_lock);
+            stats.overruns++;
+            pthread_mutex_unlock(&stats_lock);
+            deadline += ((end - deadline) / period + 1) * period;
+        }
+    }
+
+    atomic_store(&running, false);
+    return NULL;
+}
+
+// Starts the control thread
+int control_loop_start(const control_loop_config_t *config, control_tick_t tick, void *arg) {
+    control_loop_config_t cfg = {CONTROL_LOOP_DEFAULT_RATE_HZ, false, 0};
+    pthread_attr_t attr;
+    int error;
+
+    if (started || tick == NULL) {
+        return -1;
+    }
+    if (config != NULL) {
+        cfg = *config;
+    }
+    if (cfg.rate_hz < CONTROL_LOOP_MIN_RATE_HZ) cfg.rate_hz = CONTROL_LOOP_MIN_RATE_HZ;
+    if (cfg.rate_hz > CONTROL_LOOP_MAX_RATE_HZ) cfg.rate_hz = CONTROL_LOOP_MAX_RATE_HZ;
+
+    tick_fn = tick;
+    tick_arg = arg;
+    memset(&stats, 0, sizeof(stats));
+    jitter_sum_ns = 0;
+    stats.period_ns = NS_PER_S / (uint64_t)cfg.rate_hz;
+    atomic_store(&stop_requested, false);
+    atomic_store(&running, true);
+
+    pthread_attr_init(&attr);
+    if (cfg.realtime) {
+        struct sched_param param = {.sched_priority = cfg.priority};
+        pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+        pthread_attr_setschedpolicy(&attr, SCHED_FIFO);
+        pthread_attr_setschedparam(&attr, &param);
+        error = pthread_create(&thread, &attr, control_thread, NULL);
+        if (error == 0) {
+            stats.realtime = true;
+        } else {
+            // Not allowed to use SCHED_FIFO (needs CAP_SYS_NICE): use the default policy
+            fprintf(stderr, "SCHED_FIFO indisponible (%s), ordonnancement par défaut.\n", strerror(error));
+            pthread_attr_setinheritsched(&attr, PTHREAD_INHERIT_SCHED);
+            error = pthread_create(&thread, &attr, control_thread, NULL);
+        }
+    } else {
+        error = pthread_create(&thread, &attr, control_thread, NULL);
+    }
+    pthread_attr_destroy(&attr);
+
+    if (error != 0) {
+        atomic_store(&running, false);
+        fprintf(stderr, "Erreur : impossible de lancer la boucle de contrôle (%s).\n", strerror(error));
+        return -1;
+    }
+    started = true;
+    return 0;
+}
+
+// Stops the control thread and waits for its end
+void control_loop_stop(void) {
+    if (!started) {
+        return;
+    }
+    atomic_store(&stop_requested, true);
+    pthread_join(thread, NULL);
+    started = false;
+}
+
+// Checks if the control thread is still ticking
+bool control_loop_is_running(void) {
+    return atomic_load(&running);
+}
+
+// Gets a copy of the timing statistics
+control_loop_stats_t control_loop_get_stats(void) {
+    control_loop_stats_t copy;
+    pthread_mutex_lock(&stats_lock);
+    copy = stats;
+    pthread_mutex_unlock(&stats_lock);
+    return copy;
+}
+
+// Prints the timing statistics
+void control_loop_print_stats(void) {
+    control_loop_stats_t s = control_loop_get_stats();
+    printf("Boucle de contrôle : %lu ticks (période %llu us%s), %lu dépassements\n",
+           s.ticks, (unsigned long long)(s.period_ns / 1000), s.realtime ? ", SCHED_FIFO" : "",
+           s.overruns);
+    printf("  période mesurée min/max = %llu/%llu us, gigue moy/max = %llu/%llu us, tick max = %llu us\n",
+           (unsigned long long)(s.min_period_ns / 1000), (unsigned long long)(s.max_period_ns / 1000),
+           (unsigned long long)(s.mean_jitter_ns / 1000), (unsigned long long)(s.max_jitter_ns / 1000),
+           (unsigned long long)(s.max_tick_ns / 1000));
+}
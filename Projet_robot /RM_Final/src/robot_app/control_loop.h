@@ -0,0 +1,92 @@
+#ifndef CONTROL_LOOP_H
+#define CONTROL_LOOP_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "../utils.h"
+
+/**
+ * @file control_loop.h
+ * @brief Fixed-rate control thread running on absolute deadlines.
+ */
+
+/** @brief Rate of the control loop driving the robot (in Hz). */
+#define CONTROL_RATE_HZ 200
+/** @brief Nominal period of the control loop (in nanoseconds). */
+#define CONTROL_PERIOD_NS (NS_PER_S / CONTROL_RATE_HZ)
+/** @brief Default rate of the control loop (in Hz). */
+#define CONTROL_LOOP_DEFAULT_RATE_HZ CONTROL_RATE_HZ
+/** @brief Lowest accepted rate of the control loop (in Hz). */
+#define CONTROL_LOOP_MIN_RATE_HZ 1
+/** @brief Highest accepted rate of the control loop (in Hz). */
+#define CONTROL_LOOP_MAX_RATE_HZ 1000
+
+/**
+ * @brief Function called on every tick of the control loop.
+ *
+ * @param arg The argument given to control_loop_start().
+ * @return 0 to keep the loop running, any other value to end it.
+ */
+typedef int (*control_tick_t)(void *arg);
+
+/**
+ * @struct control_loop_config_t
+ * @brief Configuration of the control loop.
+ */
+typedef struct {
+    int rate_hz;   /**< Tick rate (in Hz) */
+    bool realtime; /**< Run the thread under SCHED_FIFO if allowed */
+    int priority;  /**< SCHED_FIFO priority (ignored if not realtime) */
+} control_loop_config_t;
+
+/**
+ * @struct control_loop_stats_t
+ * @brief Timing statistics of the control loop.
+ */
+typedef struct {
+    unsigned long ticks;      /**< Number of executed ticks */
+    unsigned long overruns;   /**< Number of ticks that missed their next deadline */
+    uint64_t period_ns;       /**< Nominal tick period */
+    uint64_t min_period_ns;   /**< Shortest measured period between two ticks */
+    uint64_t max_period_ns;   /**< Longest measured period between two ticks */
+    uint64_t max_jitter_ns;   /**< Worst wake-up latency after a deadline */
+    uint64_t mean_jitter_ns;  /**< Mean wake-up latency after a deadline */
+    uint64_t max_tick_ns;     /**< Longest execution time of a tick */
+    bool realtime;            /**< true if the thread runs under SCHED_FIFO */
+} control_loop_stats_t;
+
+/**
+ * @brief Starts the control thread.
+ *
+ * @param config The loop configuration (NULL for the defaults).
+ * @param tick The function to call on every tick.
+ * @param arg The argument given to the tick function.
+ * @return 0 on success, -1 if the loop is already running or cannot start.
+ */
+int control_loop_start(const control_loop_config_t *config, control_tick_t tick, void *arg);
+
+/**
+ * @brief Asks the control thread to stop and waits for its end.
+ */
+void control_loop_stop(void);
+
+/**
+ * @brief Checks if the control thread is still ticking.
+ *
+ * @return true while the loop runs, false once it has ended or been stopped.
+ */
+bool control_loop_is_running(void);
+
+/**
+ * @brief Gets the timing statistics of the current or last run.
+ *
+ * @return A copy of the statistics.
+ */
+control_loop_stats_t control_loop_get_stats(void);
+
+/**
+ * @brief Prints the timing statistics of the current or last run.
+ */
+void control_loop_print_stats(void);
+
+#endif // CONTROL_LOOP_H
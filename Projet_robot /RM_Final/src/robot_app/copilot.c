@@ -1,29 +1,66 @@
 #include "copilot.h"
 #include "pilot.h"
-#include <stdio.h>
+#include "obstacle_model.h"
+#include "logger.h"
+#include <stddef.h>
 #include <stdbool.h>
+#include "../utils.h"
 
 // Global variables to manage the path
-static move_t *path = NULL;  // Pointer to the current path
+static const move_t *path = NULL;  // Pointer to the current path (read-only)
 static path_status_t path_status = PATH_NOT_STARTED; // Current path execution status
 static int current_step = 0; // Current step index in the path
 static int path_steps = 0;   // Total number of steps in the path
+static int path_speed = 100; // Execution speed, the speeds of the moves are in % of it
+static bool blending = COPILOT_BLENDING_DEFAULT; // Look-ahead mode: blend forward moves into rotations
+static bool handover = false; // true if the current move ends without stopping
+static int blend_count = 0;   // Number of moves started without a stop
+static bool held = false;     // true while an obstacle holds the current move
+
+// Gets a move of the path at the execution speed
+static move_t scaled_move(int step) {
+    move_t move = path[step];
+    move.speed = move.speed * path_speed / 100;
+    return move;
+}
+
+// Starts the current step, and lets it roll into the next one if they can be blended
+// (the wheels go on at the handed over speed, see COPILOT_BLEND_SPEED_RATIO)
+static void start_current_step(void) {
+    move_t move = scaled_move(current_step);
+
+    if (handover) {
+        blend_count++;
+    }
+    pilot_start_move(move);
+    handover = false;
+    if (blending && current_step + 1 < path_steps &&
+        move.direction == FORWARD && path[current_step + 1].direction == ROTATION) {
+        move_t next = scaled_move(current_step + 1);
+        int speed = move.speed < next.speed ? move.speed : next.speed;
+        pilot_set_exit_speed((int)(speed * COPILOT_BLEND_SPEED_RATIO), next.speed);
+        handover = true;
+    }
+}
 
 // Start executing the path
 void copilot_start_path(void) {
     if (path == NULL || path_steps == 0) {
-        fprintf(stderr, "Erreur : Chemin non défini.\n");
+        LOG_ERROR("Erreur : Chemin non défini.\n");
         return;
     }
 
     current_step = 0;
     path_status = PATH_IN_PROGRESS;
+    handover = false;
+    blend_count = 0;
+    held = false;
 
-    printf("Démarrage du chemin. Premier déplacement : direction=%d, vitesse=%d\n",
-           path[current_step].direction, path[current_step].speed);
+    LOG_INFO("Démarrage du chemin. Premier déplacement : direction=%d, vitesse=%d\n",
+             path[current_step].direction, scaled_move(current_step).speed);
 
     // Start the first move in the path
-    pilot_start_move(path[current_step]);
+    start_current_step();
 }
 
 // Monitor the progress of the path, stopping at each step completion
@@ -33,17 +70,32 @@ path_status_t copilot_stop_at_step_completion(void) {
     }
 
     move_status_t move_status = pilot_stop_at_target();
-    if (move_status == MOVE_DONE) {
+    if ((move_status == MOVE_OBSTACLE_FORWARD) != held) {
+        held = !held;
+        if (held) {
+            obstacle_model_t obstacles = obstacle_model_get();
+            LOG_WARN("Obstacle devant (capteur %d à %d), déplacement suspendu.\n",
+                     obstacles.nearest_sensor, obstacles.nearest);
+        } else {
+            LOG_INFO("Voie libre, reprise du déplacement.\n");
+        }
+    }
+    if (move_status == MOVE_FAILED) {
+        held = false;
+        path_status = PATH_FAILED;
+        LOG_WARN("Obstacle toujours présent après %llu s, chemin abandonné à l'étape %d.\n",
+                 (unsigned long long)(PILOT_HOLD_TIMEOUT_NS / NS_PER_S), current_step);
+    } else if (move_status == MOVE_DONE) {
         current_step++;
 
         if (current_step >= path_steps) {
             path_status = PATH_COMPLETED;
-            printf("Chemin terminé.\n");
+            LOG_INFO("Chemin terminé.\n");
         } else {
             // Move to the next step in the path
-            printf("Déplacement terminé. Prochain mouvement : direction=%d, vitesse=%d\n",
-                   path[current_step].direction, path[current_step].speed);
-            pilot_start_move(path[current_step]);
+            LOG_INFO("Déplacement terminé. Prochain mouvement : direction=%d, vitesse=%d\n",
+                     path[current_step].direction, scaled_move(current_step).speed);
+            start_current_step();
         }
     }
 
@@ -55,11 +107,31 @@ bool copilot_is_path_completed(void) {
     return path_status == PATH_COMPLETED;
 }
 
+// Get the index of the step being executed
+int copilot_get_current_step(void) {
+    return current_step;
+}
+
+// Enable or disable the look-ahead blending of the moves
+void copilot_set_blending(bool enabled) {
+    blending = enabled;
+}
+
+// Get the number of moves started without stopping since the path start
+int copilot_get_blend_count(void) {
+    return blend_count;
+}
+
 // Set the path to be followed
-void copilot_set_path(move_t *new_path, int steps) {
-    printf("Configuration du chemin\n");
+void copilot_set_path(const move_t *new_path, int steps) {
+    LOG_DEBUG("Configuration du chemin\n");
 
     path = new_path;
     path_steps = steps;
     path_status = PATH_NOT_STARTED;
 }
+
+// Set the speed at which the path is executed
+void copilot_set_speed(int speed) {
+    path_speed = speed;
+}
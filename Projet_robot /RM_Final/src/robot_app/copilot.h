@@ -4,13 +4,26 @@
 #include <stdbool.h>
 #include "pilot.h" // Defines move_t structure
 
+/** @brief Look-ahead blending enabled at start-up. */
+#define COPILOT_BLENDING_DEFAULT true
+/**
+ * @brief Speed of a blended transition, as a fraction of the slower of the two moves.
+ *
+ * Both wheels leave the forward move at this speed. In the rotation, the
+ * wheel that keeps turning forward goes on from it, and the other one is
+ * brought down through 0 under the acceleration limit: the robot enters
+ * the rotation along a short arc, with no step on either wheel.
+ */
+#define COPILOT_BLEND_SPEED_RATIO 0.5
+
 /**
  * @brief Enum representing the status of a movement path.
  */
 typedef enum {
     PATH_NOT_STARTED,  // The path has not started yet
     PATH_IN_PROGRESS,  // The path is currently executing
-    PATH_COMPLETED     // The path execution is finished
+    PATH_COMPLETED,    // The path execution is finished
+    PATH_FAILED        // The path was given up: a move stayed held by an obstacle
 } path_status_t;
 
 /**
@@ -31,11 +44,41 @@ path_status_t copilot_stop_at_step_completion(void);
  */
 bool copilot_is_path_completed(void);
 
+/**
+ * @brief Gets the index of the step being executed.
+ * @return The current step index in the path.
+ */
+int copilot_get_current_step(void);
+
+/**
+ * @brief Enables or disables the look-ahead blending of the moves.
+ *
+ * When enabled, a forward move followed by a rotation is not stopped at
+ * its target: it slows down to the transition speed and the rotation
+ * starts from that speed, before the forward move fully finishes.
+ * @param enabled true to blend (default), false to stop at every step.
+ */
+void copilot_set_blending(bool enabled);
+
+/**
+ * @brief Gets the number of moves started without a stop since the path start.
+ * @return The number of blended transitions.
+ */
+int copilot_get_blend_count(void);
+
 /**
  * @brief Sets a movement path for the copilot to follow.
- * @param path Pointer to the movement sequence.
+ * The path is only read: it can be a shared table such as the predefined paths.
+ * @param path Pointer to the movement sequence, speeds in % of the execution speed.
  * @param steps Number of steps in the path.
  */
-void copilot_set_path(move_t *path, int steps);
+void copilot_set_path(const move_t *path, int steps);
+
+/**
+ * @brief Sets the speed at which the path is executed.
+ * The speed of each move is scaled by it when the move starts.
+ * @param speed The execution speed (in %, 100 by default).
+ */
+void copilot_set_speed(int speed);
 
 #endif // COPILOT_H
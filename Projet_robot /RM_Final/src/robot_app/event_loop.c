@@ -0,0 +1,131 @@
+#include "event_loop.h"
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <sys/signalfd.h>
+#include <sys/timerfd.h>
+#include <termios.h>
+#include <unistd.h>
+#include "../utils.h"
+
+/** @brief Most keys read from stdin in one call. */
+#define KEY_BUFFER_SIZE 32
+
+/**
+ * Descriptors watched by poll(), in this order.
+ */
+enum { FD_STDIN, FD_SIGNAL, FD_TIMER, FD_NB };
+
+static struct pollfd fds[FD_NB];           // Descriptors watched by event_loop_wait()
+static struct termios saved_tattr;         // Terminal settings before the raw mode
+static bool tattr_saved;                   // true if stdin is a terminal put in raw mode
+static sigset_t saved_mask;                // Signal mask before the opening
+static unsigned char keys[KEY_BUFFER_SIZE]; // Keys read but not given yet
+static int key_count;                      // Number of keys in keys
+static int key_next;                       // Next key to give
+
+// Puts stdin in raw mode: each key is readable at once, without echo
+static void set_raw_input(void) {
+    struct termios tattr;
+
+    tattr_saved = tcgetattr(STDIN_FILENO, &saved_tattr) == 0;
+    if (!tattr_saved) {
+        return;  // Not a terminal: read as it comes
+    }
+    tattr = saved_tattr;
+    tattr.c_lflag &= ~(ICANON | ECHO);
+    tattr.c_cc[VMIN] = 1;
+    tattr.c_cc[VTIME] = 0;
+    tcsetattr(STDIN_FILENO, TCSANOW, &tattr);
+}
+
+// Blocks the shutdown signals, puts stdin in raw mode and creates the descriptors
+int event_loop_open(void) {
+    sigset_t mask;
+
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGINT);
+    sigaddset(&mask, SIGTERM);
+    if (pthread_sigmask(SIG_BLOCK, &mask, &saved_mask) != 0) {
+        return -1;
+    }
+    fds[FD_SIGNAL].fd = signalfd(-1, &mask, SFD_CLOEXEC);
+    fds[FD_TIMER].fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+    if (fds[FD_SIGNAL].fd < 0 || fds[FD_TIMER].fd < 0) {
+        if (fds[FD_SIGNAL].fd >= 0) {
+            close(fds[FD_SIGNAL].fd);
+        }
+        if (fds[FD_TIMER].fd >= 0) {
+            close(fds[FD_TIMER].fd);
+        }
+        pthread_sigmask(SIG_SETMASK, &saved_mask, NULL);
+        return -1;
+    }
+    fds[FD_STDIN].fd = STDIN_FILENO;
+    for (int i = 0; i < FD_NB; i++) {
+        fds[i].events = POLLIN;
+    }
+    set_raw_input();
+    key_count = key_next = 0;
+    return 0;
+}
+
+// Arms the timer, or disarms it
+void event_loop_set_timer(uint64_t period_ns) {
+    struct itimerspec spec = {0};
+
+    spec.it_interval.tv_sec = (time_t)(period_ns / NS_PER_S);
+    spec.it_interval.tv_nsec = (long)(period_ns % NS_PER_S);
+    spec.it_value = spec.it_interval;  // First expiry one period from now
+    timerfd_settime(fds[FD_TIMER].fd, 0, &spec, NULL);
+}
+
+// Waits for the next event
+event_t event_loop_wait(void) {
+    for (;;) {
+        if (key_next < key_count) {
+            return (event_t){EVENT_KEY, keys[key_next++]};
+        }
+        if (poll(fds, FD_NB, -1) < 0) {
+            if (errno == EINTR) {
+                continue;  // Stopped by a debugger or resumed after SIGCONT
+            }
+            return (event_t){EVENT_QUIT, 0};
+        }
+
+        // Shutdown first: the other events no longer matter
+        if (fds[FD_SIGNAL].revents & POLLIN) {
+            struct signalfd_siginfo info;
+            if (read(fds[FD_SIGNAL].fd, &info, sizeof(info)) == (ssize_t)sizeof(info)) {
+                return (event_t){EVENT_QUIT, 0};
+            }
+        }
+        if (fds[FD_STDIN].revents & (POLLIN | POLLHUP | POLLERR)) {
+            ssize_t n = read(STDIN_FILENO, keys, sizeof(keys));
+            if (n <= 0 && !(n < 0 && errno == EINTR)) {
+                return (event_t){EVENT_QUIT, 0};  // End of the input
+            }
+            key_count = n > 0 ? (int)n : 0;
+            key_next = 0;
+        }
+        if (fds[FD_TIMER].revents & POLLIN) {
+            uint64_t expirations;
+            if (read(fds[FD_TIMER].fd, &expirations, sizeof(expirations)) == (ssize_t)sizeof(expirations)) {
+                return (event_t){EVENT_TIMER, 0};  // Late expiries are merged
+            }
+        }
+    }
+}
+
+// Restores stdin and the signals, and closes the descriptors
+void event_loop_close(void) {
+    if (tattr_saved) {
+        tcsetattr(STDIN_FILENO, TCSANOW, &saved_tattr);
+        tattr_saved = false;
+    }
+    close(fds[FD_SIGNAL].fd);
+    close(fds[FD_TIMER].fd);
+    pthread_sigmask(SIG_SETMASK, &saved_mask, NULL);
+}
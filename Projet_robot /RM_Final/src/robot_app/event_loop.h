@@ -0,0 +1,73 @@
+#ifndef EVENT_LOOP_H
+#define EVENT_LOOP_H
+
+#include <stdint.h>
+
+/**
+ * @file event_loop.h
+ * @brief Events of the user interface: keys, display timer and shutdown, waited in one poll().
+ *
+ * Three descriptors are watched:
+ * - stdin, put in raw mode (no line buffering, no echo) once at the
+ *   opening and restored at the closing;
+ * - a signalfd receiving SIGINT and SIGTERM, which are blocked in every
+ *   thread, so a Ctrl+C is read as an event instead of interrupting a
+ *   call;
+ * - a timerfd on the monotonic clock, armed while the interface has
+ *   something to refresh.
+ *
+ * An idle interface sleeps in poll() without any timeout: a key or a
+ * signal wakes it up at once, the timer at its deadline.
+ *
+ * event_loop_open() must be called before any thread is created, so the
+ * threads inherit the blocked signals.
+ */
+
+/**
+ * @enum event_type_t
+ * @brief Kinds of events.
+ */
+typedef enum {
+    EVENT_KEY,    /**< A key was pressed */
+    EVENT_TIMER,  /**< The timer expired (at least once) */
+    EVENT_QUIT    /**< SIGINT or SIGTERM received, or stdin closed */
+} event_type_t;
+
+/**
+ * @struct event_t
+ * @brief An event of the user interface.
+ */
+typedef struct {
+    event_type_t type;  /**< Kind of event */
+    int key;            /**< Character of the key (EVENT_KEY only) */
+} event_t;
+
+/**
+ * @brief Blocks the shutdown signals, puts stdin in raw mode and creates the descriptors.
+ *
+ * @return 0 on success, -1 on failure (nothing is left open).
+ */
+int event_loop_open(void);
+
+/**
+ * @brief Arms the timer, or disarms it.
+ *
+ * @param period_ns Period of the timer (in nanoseconds), 0 to disarm it.
+ */
+void event_loop_set_timer(uint64_t period_ns);
+
+/**
+ * @brief Waits for the next event.
+ *
+ * The keys read together are given one by one, before waiting again.
+ *
+ * @return The event.
+ */
+event_t event_loop_wait(void);
+
+/**
+ * @brief Restores stdin and the signals, and closes the descriptors.
+ */
+void event_loop_close(void);
+
+#endif // EVENT_LOOP_H
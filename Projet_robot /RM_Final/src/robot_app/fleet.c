@@ -0,0 +1,262 @@
+#include "fleet.h"
+#include "app_manager.h"
+#include "clock.h"
+#include "control_loop.h"
+#include "copilot.h"
+#include "logger.h"
+#include "speed_ctrl.h"
+#include "telemetry_shm.h"
+#include <errno.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+#include "../utils.h"
+
+/**
+ * A robot of the fleet, seen by the supervisor.
+ */
+typedef struct {
+    pid_t pid;                                // Controller process (0 once reaped)
+    int port;                                 // Port of its simulator
+    int cpu;                                  // Core it is pinned to
+    char shm_name[32];                        // Name of its segment
+    const telemetry_shm_segment_t *segment;   // Its segment (NULL until attached)
+    int exit_status;                          // Status of the ended controller
+} fleet_robot_t;
+
+static fleet_robot_t robots[FLEET_MAX_ROBOTS];  // Robots of the fleet
+static sigset_t stop_signals;                   // Signals waited by the supervisor and the controllers
+
+// Converts nanoseconds to a timespec
+static struct timespec to_timespec(uint64_t ns) {
+    return (struct timespec){(time_t)(ns / NS_PER_S), (long)(ns % NS_PER_S)};
+}
+
+// Runs one path of a controller until it ends, times out or a stop signal comes
+static int run_path(const fleet_config_t *config, int path_choice, bool *stop) {
+    const path_t *path = get_path(path_choice);
+    struct timespec poll_period = to_timespec(DELAY * 1000ULL);
+    uint64_t deadline = clock_now_ns() + config->mission_timeout_ns;  // Virtual with the native simulator
+
+    if (path == NULL) {
+        return -1;  // Unavailable (obstacle ahead, no route back...)
+    }
+    copilot_set_path(path->moves, path->steps);
+    copilot_set_speed(config->speed);
+    copilot_start_path();
+    if (start_path_execution() != 0) {
+        speed_ctrl_set_target(0, 0);
+        return -1;
+    }
+    for (;;) {
+        // Sleeps until the next check, or less if asked to stop
+        if (sigtimedwait(&stop_signals, NULL, &poll_period) > 0) {
+            *stop = true;
+            break;
+        }
+        if (check_path_completion()) {
+            return copilot_is_path_completed() ? 0 : -1;
+        }
+        if (clock_now_ns() > deadline) {
+            LOG_WARN("Mission abandonnée après %llu s\n", (unsigned long long)(config->mission_timeout_ns / NS_PER_S));
+            break;
+        }
+    }
+    control_loop_stop();
+    speed_ctrl_set_target(0, 0);
+    return -1;
+}
+
+// Controller of robot i: runs the missions without any terminal, then exits
+static void run_controller(const fleet_config_t *config, int index, const char *mission_file) {
+    fleet_robot_t *robot = &robots[index];
+    char name[64];
+    char port[16];
+    cpu_set_t cpus;
+    bool stop = false;
+
+    // Own log, core, link and segment
+    snprintf(name, sizeof(name), FLEET_LOG_FORMAT, index);
+    if (freopen(name, "w", stdout) == NULL || dup2(fileno(stdout), STDERR_FILENO) < 0) {
+        _exit(EXIT_FAILURE);
+    }
+    setvbuf(stdout, NULL, _IOLBF, 0);
+    CPU_ZERO(&cpus);
+    CPU_SET(robot->cpu, &cpus);
+    if (sched_setaffinity(0, sizeof(cpus), &cpus) != 0) {
+        printf("Robot %d : pas d'affinité au cœur %d\n", index, robot->cpu);
+    }
+    snprintf(port, sizeof(port), "%d", robot->port);
+    setenv(ROBOT_PORT_ENV, port, 1);
+    if (config->address != NULL) {
+        setenv(ROBOT_ADDRESS_ENV, config->address, 1);
+    }
+    logger_open();
+    if (robot_start() != 0) {
+        logger_close();
+        _exit(EXIT_FAILURE);
+    }
+    if (telemetry_shm_open(robot->shm_name) != 0) {
+        printf("Robot %d : télémétrie partagée %s désactivée\n", index, robot->shm_name);
+    }
+    if (mission_file != NULL && load_mission(mission_file) != 0) {
+        printf("Robot %d : mission %s non chargée\n", index, mission_file);
+    }
+
+    // Mission, then back to the start for the next one
+    for (unsigned long done = 0; !stop && (config->missions == 0 || done < config->missions); done++) {
+        bool completed = run_path(config, config->path_choice, &stop) == 0;
+        telemetry_shm_count_mission(completed);
+        if (!stop && run_path(config, RETURN_CHOICE, &stop) != 0 && !stop) {
+            printf("Robot %d : pas de retour au départ\n", index);
+        }
+        if (!completed && !stop && config->missions == 0) {
+            // Nothing will change by itself: wait a little before trying again
+            struct timespec pause = to_timespec(FLEET_REPORT_PERIOD_NS);
+            if (sigtimedwait(&stop_signals, NULL, &pause) > 0) {
+                stop = true;
+            }
+        }
+    }
+
+    robot_close();
+    telemetry_shm_close();
+    logger_close();
+    fflush(stdout);
+    _exit(EXIT_SUCCESS);
+}
+
+// Prints the throughput of the fleet and the health of each control loop
+static void print_report(const fleet_config_t *config, uint64_t start_ns) {
+    uint64_t now = monotonic_ns();
+    double hours = (double)(now - start_ns) / 3600e9;
+    unsigned int total = 0, total_failed = 0;
+
+    for (int i = 0; i < config->robots; i++) {
+        fleet_robot_t *robot = &robots[i];
+        telemetry_shm_state_t state;
+        unsigned int completed = 0, failed = 0;
+
+        if (robot->segment == NULL && robot->pid != 0) {
+            robot->segment = telemetry_shm_attach(robot->shm_name);  // Created once the controller has started
+        }
+        if (robot->segment == NULL) {
+            printf("  robot %2d (port %d, cœur %d) : %s\n", i, robot->port, robot->cpu,
+                   robot->pid != 0 ? "démarrage" : "arrêté");
+            continue;
+        }
+        telemetry_shm_get_missions(robot->segment, &completed, &failed);
+        total += completed;
+        total_failed += failed;
+        if (!telemetry_shm_read(robot->segment, &state) || state.publications == 0) {
+            printf("  robot %2d (port %d, cœur %d) : %u missions, %u abandonnées, boucle pas encore démarrée\n",
+                   i, robot->port, robot->cpu, completed, failed);
+            continue;
+        }
+        uint64_t age = now > state.record.publish_ns ? now - state.record.publish_ns : 0;
+        printf("  robot %2d (port %d, cœur %d) : %u missions, %u abandonnées, %lu ticks, %lu dépassements, "
+               "gigue moy/max %llu/%llu us, tick max %llu us, %s\n",
+               i, robot->port, robot->cpu, completed, failed, state.loop.ticks, state.loop.overruns,
+               (unsigned long long)(state.loop.mean_jitter_ns / 1000), (unsigned long long)(state.loop.max_jitter_ns / 1000),
+               (unsigned long long)(state.loop.max_tick_ns / 1000),
+               robot->pid == 0 ? "arrêté" : (age > FLEET_STALL_NS ? "boucle à l'arrêt" : "en marche"));
+    }
+    printf("Flotte : %d robots, %u missions terminées, %u abandonnées, %.1f missions/h\n",
+           config->robots, total, total_failed, hours > 0.0 ? (double)total / hours : 0.0);
+    fflush(stdout);
+}
+
+// Reaps the ended controllers
+static int reap_controllers(const fleet_config_t *config) {
+    int status, alive = 0;
+    pid_t pid;
+
+    while ((pid = waitpid(-1, &status, WNOHANG)) > 0) {
+        for (int i = 0; i < config->robots; i++) {
+            if (robots[i].pid == pid) {
+                robots[i].pid = 0;
+                robots[i].exit_status = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+            }
+        }
+    }
+    for (int i = 0; i < config->robots; i++) {
+        alive += robots[i].pid != 0;
+    }
+    return alive;
+}
+
+// Starts the controllers and supervises them
+int fleet_run(const fleet_config_t *config, const char *mission_file) {
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+    struct timespec period = to_timespec(FLEET_REPORT_PERIOD_NS);
+    sigset_t supervisor_signals;
+    uint64_t start_ns;
+    int result = 0;
+
+    if (config->robots < 1 || config->robots > FLEET_MAX_ROBOTS) {
+        fprintf(stderr, "Flotte : de 1 à %d robots\n", FLEET_MAX_ROBOTS);
+        return -1;
+    }
+
+    // Stop signals are waited, never delivered: the controllers inherit the mask
+    sigemptyset(&stop_signals);
+    sigaddset(&stop_signals, SIGINT);
+    sigaddset(&stop_signals, SIGTERM);
+    supervisor_signals = stop_signals;
+    sigaddset(&supervisor_signals, SIGCHLD);
+    sigprocmask(SIG_BLOCK, &supervisor_signals, NULL);
+
+    printf("Flotte de %d robots (ports %d à %d), Ctrl+C pour arrêter\n",
+           config->robots, config->base_port, config->base_port + config->robots - 1);
+    fflush(stdout);
+    for (int i = 0; i < config->robots; i++) {
+        fleet_robot_t *robot = &robots[i];
+
+        robot->port = config->base_port + i;
+        robot->cpu = (int)(i % (online > 0 ? online : 1));
+        snprintf(robot->shm_name, sizeof(robot->shm_name), FLEET_SHM_FORMAT, i);
+        robot->pid = fork();
+        if (robot->pid == 0) {
+            run_controller(config, i, mission_file);  // Never returns
+        }
+        if (robot->pid < 0) {
+            perror("fork");
+            robot->pid = 0;
+            result = -1;
+        }
+    }
+
+    start_ns = monotonic_ns();
+    while (reap_controllers(config) > 0) {
+        int signal = sigtimedwait(&supervisor_signals, NULL, &period);
+
+        if (signal == SIGINT || signal == SIGTERM) {
+            printf("Arrêt de la flotte\n");
+            for (int i = 0; i < config->robots; i++) {
+                if (robots[i].pid != 0) {
+                    kill(robots[i].pid, SIGTERM);
+                }
+            }
+        } else if (signal < 0 && errno == EAGAIN) {
+            print_report(config, start_ns);  // A period without any event
+        }
+    }
+
+    print_report(config, start_ns);
+    for (int i = 0; i < config->robots; i++) {
+        if (robots[i].exit_status != 0) {
+            printf("  robot %d : contrôleur terminé avec le code %d (voir " FLEET_LOG_FORMAT ")\n",
+                   i, robots[i].exit_status, i);
+            result = -1;
+        }
+        if (robots[i].segment != NULL) {
+            telemetry_shm_detach(robots[i].segment);
+        }
+    }
+    return result;
+}
@@ -0,0 +1,66 @@
+#ifndef FLEET_H
+#define FLEET_H
+
+#include <stdint.h>
+#include "robot.h"
+
+/**
+ * @file fleet.h
+ * @brief Supervisor of several robots, one controller process each.
+ *
+ * The link to a robot is global to a process, so each robot gets its own
+ * controller, forked by the supervisor:
+ * - bound at run time to its simulator (ROBOT_ADDRESS_ENV, and
+ *   ROBOT_PORT_ENV from base_port upwards),
+ * - pinned to one core (robot i on core i modulo the online cores),
+ * - publishing its state in its own shared memory segment
+ *   (FLEET_SHM_FORMAT, see telemetry_shm.h),
+ * - writing its messages in its own log file (FLEET_LOG_FORMAT),
+ * - running the mission path and then the planned return to the start,
+ *   again and again, without any terminal.
+ *
+ * The supervisor reads the segments every FLEET_REPORT_PERIOD_NS and
+ * prints the throughput of the fleet (missions per hour) and the health
+ * of each control loop. Ctrl+C or SIGTERM stops every controller.
+ *
+ * fleet_run() must be called before any thread is created.
+ */
+
+/** @brief Most robots of a fleet. */
+#define FLEET_MAX_ROBOTS 64
+/** @brief Shared memory segment of robot i. */
+#define FLEET_SHM_FORMAT "/mrpiz_telemetry.%d"
+/** @brief Log file of robot i (stdout and stderr of its controller). */
+#define FLEET_LOG_FORMAT "../bin/fleet_robot%d.log"
+/** @brief Period of the reports of the supervisor (in nanoseconds). */
+#define FLEET_REPORT_PERIOD_NS 1000000000ULL
+/** @brief Publication age after which a control loop is reported as stalled (in nanoseconds). */
+#define FLEET_STALL_NS 500000000ULL
+
+/**
+ * @struct fleet_config_t
+ * @brief Settings of a fleet.
+ */
+typedef struct {
+    int robots;                   /**< Number of robots (0 for no fleet, up to FLEET_MAX_ROBOTS) */
+    const char *address;          /**< Address of the simulators (NULL for ROBOT_DEFAULT_ADDRESS) */
+    int base_port;                /**< Port of robot 0, robot i uses base_port + i */
+    int path_choice;              /**< Menu key of the mission path */
+    int speed;                    /**< Speed of the missions (in %) */
+    unsigned long missions;       /**< Missions of each robot (0 until stopped) */
+    uint64_t mission_timeout_ns;  /**< Time after which a mission is given up (in nanoseconds) */
+} fleet_config_t;
+
+/** @brief Default settings: no fleet; path 1 at 50 %, given up after 2 minutes. */
+#define FLEET_DEFAULT_CONFIG {0, NULL, ROBOT_DEFAULT_PORT, 7, 50, 0, 120000000000ULL}
+
+/**
+ * @brief Starts the controllers and supervises them until they end or are stopped.
+ *
+ * @param config The settings of the fleet.
+ * @param mission_file Mission file of MISSION_CHOICE (NULL if none).
+ * @return 0 if every controller ended normally, -1 otherwise.
+ */
+int fleet_run(const fleet_config_t *config, const char *mission_file);
+
+#endif // FLEET_H
@@ -0,0 +1,97 @@
+#include "flight_recorder.h"
+#include "clock.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "../utils.h"
+
+_Static_assert(sizeof(flight_header_t) == 64, "flight_header_t is 64 bytes in the file format");
+_Static_assert(sizeof(flight_header_t) % _Alignof(flight_record_t) == 0, "the records must stay aligned");
+
+static flight_header_t *header = NULL;   // Mapped header (NULL when closed)
+static flight_record_t *records = NULL;  // Mapped ring of records
+static size_t mapped_size = 0;           // Size of the mapping
+
+// Creates the recording file and maps it in memory
+int flight_recorder_open(const char *path, uint32_t capacity) {
+    int fd;
+    void *map;
+
+    if (header != NULL) {
+        flight_recorder_close();
+    }
+    if (capacity == 0) {
+        capacity = FLIGHT_RECORDER_DEFAULT_CAPACITY;
+    }
+    mapped_size = sizeof(flight_header_t) + (size_t)capacity * sizeof(flight_record_t);
+
+    fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        perror("flight_recorder_open");
+        return -1;
+    }
+    if (ftruncate(fd, (off_t)mapped_size) != 0) {
+        perror("flight_recorder_open");
+        close(fd);
+        return -1;
+    }
+    // Populate the pages now so the control loop never takes a page fault
+    map = mmap(NULL, mapped_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        perror("flight_recorder_open");
+        return -1;
+    }
+
+    header = map;
+    records = (flight_record_t *)(header + 1);
+    *header = (flight_header_t){
+        .magic = FLIGHT_RECORDER_MAGIC,
+        .version = FLIGHT_RECORDER_VERSION,
+        .record_size = sizeof(flight_record_t),
+        .capacity = capacity,
+        .written = 0,
+        .start_ns = clock_now_ns()
+    };
+    return 0;
+}
+
+// Appends one tick to the recording
+void flight_recorder_log(const telemetry_record_t *record, speed_pct_t left_speed, speed_pct_t right_speed) {
+    if (header == NULL) {
+        return;
+    }
+    const robot_status_t *status = &record->snapshot.status;
+    flight_record_t *slot = &records[header->written % header->capacity];
+
+    *slot = (flight_record_t){
+        .timestamp_ns = record->snapshot.timestamp_ns,
+        .seq = record->snapshot.seq,
+        .left_encoder = status->left_encoder,
+        .right_encoder = status->right_encoder,
+        .sensors = {(int16_t)status->sensors[SENSOR_LEFT], (int16_t)status->sensors[SENSOR_CENTER_LEFT],
+                    (int16_t)status->sensors[SENSOR_CENTER], (int16_t)status->sensors[SENSOR_CENTER_RIGHT],
+                    (int16_t)status->sensors[SENSOR_RIGHT]},
+        .battery = (int16_t)status->battery,
+        .left_speed = (int16_t)left_speed,
+        .right_speed = (int16_t)right_speed,
+        .step = (int16_t)record->step,
+        .move_status = (uint8_t)record->move_status,
+        .path_status = (uint8_t)record->path_status
+    };
+    // Published last: a crash never exposes a half-written record
+    __atomic_store_n(&header->written, header->written + 1, __ATOMIC_RELEASE);
+}
+
+// Flushes and unmaps the recording file
+void flight_recorder_close(void) {
+    if (header == NULL) {
+        return;
+    }
+    msync(header, mapped_size, MS_SYNC);
+    munmap(header, mapped_size);
+    header = NULL;
+    records = NULL;
+}
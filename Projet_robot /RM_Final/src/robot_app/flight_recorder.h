@@ -0,0 +1,81 @@
+#ifndef FLIGHT_RECORDER_H
+#define FLIGHT_RECORDER_H
+
+#include <stdint.h>
+#include "robot.h"
+#include "telemetry.h"
+
+/**
+ * @file flight_recorder.h
+ * @brief Binary flight recorder of the control loop, in a memory-mapped ring file.
+ *
+ * Each control tick appends one fixed-size record with a plain memory copy
+ * (no system call). Once the ring is full the oldest records are overwritten.
+ * The file is read offline with the flight_dump tool (make flight_dump).
+ */
+
+/** @brief Magic number at the start of a recording ("FLRC"). */
+#define FLIGHT_RECORDER_MAGIC 0x43524C46u
+/** @brief Version of the record layout. */
+#define FLIGHT_RECORDER_VERSION 2
+/** @brief Default recording file, next to the executable. */
+#define FLIGHT_RECORDER_DEFAULT_PATH "../bin/flight.rec"
+/** @brief Default number of records in the ring (about 5 minutes at 200 Hz). */
+#define FLIGHT_RECORDER_DEFAULT_CAPACITY 65536
+
+/**
+ * @struct flight_header_t
+ * @brief Header at the start of a recording file.
+ */
+typedef struct {
+    uint32_t magic;       /**< FLIGHT_RECORDER_MAGIC */
+    uint32_t version;     /**< FLIGHT_RECORDER_VERSION */
+    uint32_t record_size; /**< sizeof(flight_record_t) */
+    uint32_t capacity;    /**< Number of records in the ring */
+    uint64_t written;     /**< Total number of records written since the opening */
+    uint64_t start_ns;    /**< Time of the opening on the robot clock (see clock.h) */
+    uint8_t reserved[32]; /**< Pads the header to 64 bytes: the 40-byte records start 8-byte aligned */
+} flight_header_t;
+
+/**
+ * @struct flight_record_t
+ * @brief One control tick, in a fixed-width layout.
+ */
+typedef struct {
+    uint64_t timestamp_ns;  /**< Time of the status acquisition on the robot clock */
+    uint32_t seq;           /**< Snapshot sequence number */
+    int32_t left_encoder;   /**< Left wheel encoder */
+    int32_t right_encoder;  /**< Right wheel encoder */
+    int16_t sensors[SENSOR_NB]; /**< Proximity sensors, from left to right */
+    int16_t battery;        /**< Battery level */
+    int16_t left_speed;     /**< Commanded left wheel speed */
+    int16_t right_speed;    /**< Commanded right wheel speed */
+    int16_t step;           /**< Current path step */
+    uint8_t move_status;    /**< move_status_t */
+    uint8_t path_status;    /**< path_status_t */
+} flight_record_t;
+
+/**
+ * @brief Creates (or truncates) a recording file and maps it in memory.
+ *
+ * @param path The recording file.
+ * @param capacity The number of records in the ring (0 for the default).
+ * @return 0 on success, -1 on error (recording stays disabled).
+ */
+int flight_recorder_open(const char *path, uint32_t capacity);
+
+/**
+ * @brief Appends one tick to the recording (no-op if the recorder is closed).
+ *
+ * @param record The telemetry of the tick.
+ * @param left_speed The commanded left wheel speed.
+ * @param right_speed The commanded right wheel speed.
+ */
+void flight_recorder_log(const telemetry_record_t *record, speed_pct_t left_speed, speed_pct_t right_speed);
+
+/**
+ * @brief Flushes and unmaps the recording file.
+ */
+void flight_recorder_close(void);
+
+#endif // FLIGHT_RECORDER_H
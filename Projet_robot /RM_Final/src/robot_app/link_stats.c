@@ -0,0 +1,133 @@
+#include "link_stats.h"
+#include <stdio.h>
+
+/**
+ * Histogram of one call type.
+ */
+typedef struct {
+    uint64_t buckets[LINK_STATS_BUCKET_NB];
+    uint64_t count;
+    uint64_t sum_ns;
+    uint64_t max_ns;
+} histogram_t;
+
+static histogram_t histograms[MRPIZ_CALL_NB];  // One histogram per call type
+static bool enabled = true;                   // Recording switch
+
+static const char *const call_names[MRPIZ_CALL_NB] = {
+    "init", "close", "motor_set", "encoder_get", "encoder_reset",
+    "proxy_sensor_get", "battery_level", "led_rgb_set"
+};
+
+// Bucket of a latency: exact below 8 ns, then 4 buckets per power of 2
+static unsigned int bucket_of(uint64_t ns) {
+    if (ns < 8) {
+        return (unsigned int)ns;
+    }
+    unsigned int msb = 63u - (unsigned int)__builtin_clzll(ns);
+    return (msb - 1u) * 4u + (unsigned int)((ns >> (msb - 2u)) & 3u);
+}
+
+// Highest latency falling in a bucket
+static uint64_t bucket_upper(unsigned int bucket) {
+    if (bucket < 8) {
+        return bucket;
+    }
+    unsigned int msb = bucket / 4u + 1u;
+    uint64_t width = 1ULL << (msb - 2u);
+    return (4u + bucket % 4u) * width + width - 1u;
+}
+
+// Latency under which a given fraction of the calls fall
+static uint64_t percentile(const histogram_t *h, uint64_t count, double fraction) {
+    uint64_t rank = (uint64_t)((double)count * fraction);
+    uint64_t seen = 0;
+
+    if (rank >= count) {
+        rank = count - 1;
+    }
+    for (unsigned int b = 0; b < LINK_STATS_BUCKET_NB; b++) {
+        seen += __atomic_load_n(&h->buckets[b], __ATOMIC_RELAXED);
+        if (seen > rank) {
+            return bucket_upper(b);
+        }
+    }
+    return bucket_upper(LINK_STATS_BUCKET_NB - 1);
+}
+
+// Enables or disables the recording
+void link_stats_set_enabled(bool on) {
+    __atomic_store_n(&enabled, on, __ATOMIC_RELAXED);
+}
+
+// Checks if the latencies are recorded
+bool link_stats_enabled(void) {
+    return __atomic_load_n(&enabled, __ATOMIC_RELAXED);
+}
+
+// Adds to a counter without a locked instruction
+static inline void counter_add(uint64_t *counter, uint64_t value) {
+    __atomic_store_n(counter, __atomic_load_n(counter, __ATOMIC_RELAXED) + value, __ATOMIC_RELAXED);
+}
+
+// Records the latency of one call
+void link_stats_record(mrpiz_call_t call, uint64_t latency_ns) {
+    histogram_t *h = &histograms[call];
+
+    // Plain relaxed updates rather than locked read-modify-writes: nearly all
+    // calls come from the control thread, and losing a count when the UI
+    // thread calls at the same instant is acceptable for a statistic.
+    counter_add(&h->buckets[bucket_of(latency_ns)], 1);
+    counter_add(&h->count, 1);
+    counter_add(&h->sum_ns, latency_ns);
+    if (latency_ns > __atomic_load_n(&h->max_ns, __ATOMIC_RELAXED)) {
+        __atomic_store_n(&h->max_ns, latency_ns, __ATOMIC_RELAXED);
+    }
+}
+
+// Gets the latency summary of one call type
+link_latency_t link_stats_get(mrpiz_call_t call) {
+    const histogram_t *h = &histograms[call];
+    link_latency_t summary = {0};
+
+    summary.count = __atomic_load_n(&h->count, __ATOMIC_RELAXED);
+    if (summary.count == 0) {
+        return summary;
+    }
+    summary.mean_ns = __atomic_load_n(&h->sum_ns, __ATOMIC_RELAXED) / summary.count;
+    summary.max_ns = __atomic_load_n(&h->max_ns, __ATOMIC_RELAXED);
+    summary.p50_ns = percentile(h, summary.count, 0.50);
+    summary.p99_ns = percentile(h, summary.count, 0.99);
+    // A bucket upper bound may exceed the true maximum
+    if (summary.p50_ns > summary.max_ns) summary.p50_ns = summary.max_ns;
+    if (summary.p99_ns > summary.max_ns) summary.p99_ns = summary.max_ns;
+    return summary;
+}
+
+// Prints the latency summary of every call type that was made
+void link_stats_print(void) {
+    printf("Latences du lien mrpiz (us) :\n");
+    printf("  %-18s %10s %10s %10s %10s %10s\n", "appel", "nombre", "moyenne", "p50", "p99", "max");
+    for (int call = 0; call < MRPIZ_CALL_NB; call++) {
+        link_latency_t s = link_stats_get((mrpiz_call_t)call);
+        if (s.count == 0) {
+            continue;
+        }
+        printf("  %-18s %10llu %10.1f %10.1f %10.1f %10.1f\n", call_names[call],
+               (unsigned long long)s.count, (double)s.mean_ns / 1e3, (double)s.p50_ns / 1e3,
+               (double)s.p99_ns / 1e3, (double)s.max_ns / 1e3);
+    }
+}
+
+// Clears all the histograms
+void link_stats_reset(void) {
+    for (int call = 0; call < MRPIZ_CALL_NB; call++) {
+        histogram_t *h = &histograms[call];
+        for (unsigned int b = 0; b < LINK_STATS_BUCKET_NB; b++) {
+            __atomic_store_n(&h->buckets[b], 0, __ATOMIC_RELAXED);
+        }
+        __atomic_store_n(&h->count, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&h->sum_ns, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&h->max_ns, 0, __ATOMIC_RELAXED);
+    }
+}
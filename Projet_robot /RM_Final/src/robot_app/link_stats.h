@@ -0,0 +1,73 @@
+#ifndef LINK_STATS_H
+#define LINK_STATS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "mrpiz_trace.h"
+
+/**
+ * @file link_stats.h
+ * @brief Latency histograms of the mrpiz calls made through robot.c.
+ *
+ * Each call type has a log-bucketed histogram (4 buckets per power of 2,
+ * so a percentile is known within 25 %). Recording costs a few relaxed
+ * loads and stores, with the two clock reads of the wrapper about 80 ns
+ * per call; it can be done from any thread.
+ */
+
+/** @brief Number of buckets per histogram. */
+#define LINK_STATS_BUCKET_NB 252
+
+/**
+ * @struct link_latency_t
+ * @brief Latency summary of one call type.
+ */
+typedef struct {
+    uint64_t count;    /**< Number of calls */
+    uint64_t mean_ns;  /**< Mean latency */
+    uint64_t p50_ns;   /**< Median latency (bucket upper bound) */
+    uint64_t p99_ns;   /**< 99th percentile latency (bucket upper bound) */
+    uint64_t max_ns;   /**< Highest latency */
+} link_latency_t;
+
+/**
+ * @brief Enables or disables the recording (enabled by default).
+ *
+ * @param enabled true to record the call latencies.
+ */
+void link_stats_set_enabled(bool enabled);
+
+/**
+ * @brief Checks if the latencies are recorded.
+ *
+ * @return true if enabled.
+ */
+bool link_stats_enabled(void);
+
+/**
+ * @brief Records the latency of one call.
+ *
+ * @param call The call identifier.
+ * @param latency_ns The call duration (in nanoseconds).
+ */
+void link_stats_record(mrpiz_call_t call, uint64_t latency_ns);
+
+/**
+ * @brief Gets the latency summary of one call type.
+ *
+ * @param call The call identifier.
+ * @return The summary (all zero if the call was never made).
+ */
+link_latency_t link_stats_get(mrpiz_call_t call);
+
+/**
+ * @brief Prints the latency summary of every call type that was made.
+ */
+void link_stats_print(void);
+
+/**
+ * @brief Clears all the histograms.
+ */
+void link_stats_reset(void);
+
+#endif // LINK_STATS_H
@@ -0,0 +1,265 @@
+#include "logger.h"
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <semaphore.h>
+#include <stdalign.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include "../utils.h"
+
+_Static_assert((LOG_RING_SIZE & (LOG_RING_SIZE - 1)) == 0, "LOG_RING_SIZE must be a power of 2");
+
+/** @brief Size of a cache line, to keep the producers and the consumer apart. */
+#define LOG_CACHE_LINE 64
+/** @brief Longest formatted record (longer ones are truncated). */
+#define LOG_LINE_SIZE 256
+/** @brief Longest conversion specification (e.g. "%-08.3lld"). */
+#define LOG_SPEC_SIZE 16
+
+/**
+ * Record of a log call, as stored by the caller.
+ */
+typedef struct {
+    uint64_t timestamp_ns;        // Monotonic time of the call
+    const char *file;             // Source file of the call
+    const char *format;           // printf format of the message
+    int line;                     // Source line of the call
+    int level;                    // Level of the record
+    int arg_count;                // Number of arguments
+    log_arg_t args[LOG_MAX_ARGS]; // Raw arguments
+} log_record_t;
+
+/**
+ * Slot of the ring. Its sequence tells its state for the lap
+ * (position & ~mask) of a position: equal, the slot is free; one
+ * more, the record is ready; lower, the record of the previous lap is
+ * not read yet (the ring is full).
+ */
+typedef struct {
+    atomic_uint_fast64_t seq;
+    log_record_t record;
+} log_slot_t;
+
+/**
+ * Lock-free ring: the producers claim a position with a CAS on head,
+ * the logger thread alone reads at tail. All zeros is an empty ring.
+ */
+static struct {
+    alignas(LOG_CACHE_LINE) atomic_uint_fast64_t head;  // Next position to claim (producers)
+    atomic_ulong dropped;                               // Records dropped on a full ring
+    alignas(LOG_CACHE_LINE) uint_fast64_t tail;         // Next position to read (logger thread)
+    log_slot_t slots[LOG_RING_SIZE];
+} ring;
+
+static const char level_tags[] = {'D', 'I', 'W', 'E'};  // Tag of each level in the output
+static sem_t pending;              // Posted once per record stored while the thread runs
+static bool pending_ready;         // true once pending is initialized (never destroyed: late producers may post)
+static atomic_bool running;        // true while the logger thread runs
+static atomic_bool stopping;       // Asks the logger thread to drain the ring and end
+static pthread_t thread;           // Logger thread
+static uint64_t open_ns;           // Time origin of the output
+
+// Stores a record in the ring, never waiting
+void logger_log(int level, const char *file, int line, const char *format, const log_arg_t *args, int arg_count) {
+    uint_fast64_t pos = atomic_load_explicit(&ring.head, memory_order_relaxed);
+    log_slot_t *slot;
+
+    for (;;) {
+        slot = &ring.slots[pos & (LOG_RING_SIZE - 1)];
+        uint_fast64_t seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+        int_fast64_t diff = (int_fast64_t)(seq - (pos & ~(uint_fast64_t)(LOG_RING_SIZE - 1)));
+
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&ring.head, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                break;  // Position claimed
+            }
+        } else if (diff < 0) {
+            atomic_fetch_add_explicit(&ring.dropped, 1, memory_order_relaxed);  // Full: never wait
+            return;
+        } else {
+            pos = atomic_load_explicit(&ring.head, memory_order_relaxed);  // Claimed by another thread
+        }
+    }
+
+    slot->record.timestamp_ns = monotonic_ns();
+    slot->record.file = file;
+    slot->record.format = format;
+    slot->record.line = line;
+    slot->record.level = level;
+    slot->record.arg_count = arg_count < LOG_MAX_ARGS ? arg_count : LOG_MAX_ARGS;
+    memcpy(slot->record.args, args, (size_t)slot->record.arg_count * sizeof(log_arg_t));
+    atomic_store_explicit(&slot->seq, (pos & ~(uint_fast64_t)(LOG_RING_SIZE - 1)) + 1, memory_order_release);
+
+    if (atomic_load_explicit(&running, memory_order_acquire)) {
+        sem_post(&pending);  // No system call while the thread is awake
+    }
+}
+
+// Takes the record at tail if it is ready (logger thread only)
+static bool ring_pop(log_record_t *record) {
+    log_slot_t *slot = &ring.slots[ring.tail & (LOG_RING_SIZE - 1)];
+    uint_fast64_t lap = ring.tail & ~(uint_fast64_t)(LOG_RING_SIZE - 1);
+
+    if (atomic_load_explicit(&slot->seq, memory_order_acquire) != lap + 1) {
+        return false;  // Empty, or still being written
+    }
+    *record = slot->record;
+    atomic_store_explicit(&slot->seq, lap + LOG_RING_SIZE, memory_order_release);
+    ring.tail++;
+    return true;
+}
+
+// The formats are checked by the compiler at each call (log_check_format)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wformat-nonliteral"
+
+// Formats one conversion specification with its raw argument
+static int format_arg(char *out, size_t size, const char *spec, char conversion, log_arg_t arg) {
+    bool is_long_long = strstr(spec, "ll") != NULL || strchr(spec, 'j') != NULL;
+    bool is_long = !is_long_long && strchr(spec, 'l') != NULL;
+    bool is_size = strchr(spec, 'z') != NULL || strchr(spec, 't') != NULL;
+
+    switch (conversion) {
+        case 'd': case 'i':
+            if (is_long_long) return snprintf(out, size, spec, arg.i);
+            if (is_long || is_size) return snprintf(out, size, spec, (long)arg.i);
+            return snprintf(out, size, spec, (int)arg.i);
+        case 'o': case 'u': case 'x': case 'X':
+            if (is_long_long) return snprintf(out, size, spec, (unsigned long long)arg.i);
+            if (is_long || is_size) return snprintf(out, size, spec, (unsigned long)arg.i);
+            return snprintf(out, size, spec, (unsigned)arg.i);
+        case 'c':
+            return snprintf(out, size, spec, (int)arg.i);
+        case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+            return snprintf(out, size, spec, arg.d);
+        case 's':
+            return snprintf(out, size, spec, arg.p != NULL ? (const char *)arg.p : "(null)");
+        case 'p':
+            return snprintf(out, size, spec, arg.p);
+        default:
+            return 0;
+    }
+}
+
+#pragma GCC diagnostic pop
+
+// Formats a record as printf would have done at the call
+static void format_record(const log_record_t *record, char *out, size_t size) {
+    const char *f = record->format;
+    size_t len = 0;
+    int arg = 0;
+
+    int n = snprintf(out, size, "[%9.3f] %c ", (double)(int64_t)(record->timestamp_ns - open_ns) / 1e9,
+                     level_tags[record->level]);
+    len = n > 0 ? (size_t)n : 0;
+
+    while (*f != '\0' && len + 1 < size) {
+        if (*f != '%') {
+            out[len++] = *f++;
+            continue;
+        }
+        if (f[1] == '%') {
+            out[len++] = '%';
+            f += 2;
+            continue;
+        }
+
+        // Copy the specification up to its conversion character
+        char spec[LOG_SPEC_SIZE];
+        size_t spec_len = 0;
+        do {
+            spec[spec_len++] = *f++;
+        } while (*f != '\0' && strchr("diouxXcsfFeEgGaAp", *f) == NULL && spec_len + 2 < LOG_SPEC_SIZE);
+        char conversion = *f;
+        if (conversion == '\0') {
+            break;
+        }
+        spec[spec_len++] = *f++;
+        spec[spec_len] = '\0';
+
+        if (arg >= record->arg_count) {
+            n = snprintf(out + len, size - len, "?");  // More conversions than arguments stored
+        } else {
+            n = format_arg(out + len, size - len, spec, conversion, record->args[arg++]);
+        }
+        len += n > 0 ? (size_t)n : 0;
+        len = len < size ? len : size - 1;
+    }
+    out[len] = '\0';
+}
+
+// Writes every ready record (logger thread only)
+static void drain(void) {
+    log_record_t record;
+    char line[LOG_LINE_SIZE];
+    bool written = false;
+
+    while (ring_pop(&record)) {
+        format_record(&record, line, sizeof(line));
+        fputs(line, stderr);
+        written = true;
+    }
+    if (written) {
+        fflush(stderr);  // Once per batch, not per record
+    }
+}
+
+// Logger thread: sleeps until records are stored, then formats and writes them
+static void *logger_thread(void *unused) {
+    (void)unused;
+    while (!atomic_load_explicit(&stopping, memory_order_acquire)) {
+        if (sem_wait(&pending) != 0 && errno != EINTR) {
+            break;
+        }
+        drain();
+        // A record may be claimed before another one, but published after it
+        while (atomic_load_explicit(&ring.head, memory_order_acquire) != ring.tail &&
+               !atomic_load_explicit(&stopping, memory_order_acquire)) {
+            sched_yield();
+            drain();
+        }
+    }
+    drain();
+    return NULL;
+}
+
+// Starts the logger thread
+int logger_open(void) {
+    if (atomic_load(&running)) {
+        return 0;
+    }
+    open_ns = monotonic_ns();
+    atomic_store(&stopping, false);
+    if (!pending_ready) {
+        if (sem_init(&pending, 0, 0) != 0) {
+            return -1;
+        }
+        pending_ready = true;
+    }
+    sem_post(&pending);  // Writes the records logged before the opening
+    if (pthread_create(&thread, NULL, logger_thread, NULL) != 0) {
+        return -1;
+    }
+    atomic_store(&running, true);
+    return 0;
+}
+
+// Writes the pending records and stops the logger thread
+void logger_close(void) {
+    if (!atomic_load(&running)) {
+        return;
+    }
+    atomic_store(&running, false);
+    atomic_store(&stopping, true);
+    sem_post(&pending);
+    pthread_join(thread, NULL);
+}
+
+// Gets the number of records dropped because the ring was full
+unsigned long logger_get_dropped(void) {
+    return atomic_load_explicit(&ring.dropped, memory_order_relaxed);
+}
@@ -0,0 +1,160 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <stdint.h>
+
+/**
+ * @file logger.h
+ * @brief Leveled logging, formatted and written by a background thread.
+ *
+ * The levels below LOG_LEVEL are compiled out: their calls are only kept
+ * for the format checks of the compiler, and cost nothing at run time.
+ *
+ * An enabled call does not format anything: it stores the format, the
+ * place of the call and the raw arguments in a lock-free ring shared by
+ * all the threads, and the logger thread formats and writes them to
+ * stderr later. A record is dropped (and counted) if the ring is full,
+ * so a log call never waits.
+ *
+ * As the formatting is deferred:
+ * - a "%s" argument must still exist when the record is written (a string
+ *   literal, not a buffer of the caller);
+ * - at most LOG_MAX_ARGS arguments are stored, and "*" widths are not
+ *   supported.
+ *
+ * Records logged before logger_open() wait in the ring.
+ */
+
+#define LOG_LEVEL_DEBUG 0  /**< Details of the decisions (moves, wall following) */
+#define LOG_LEVEL_INFO 1   /**< Progress of the paths */
+#define LOG_LEVEL_WARN 2   /**< Unexpected but handled situations */
+#define LOG_LEVEL_ERROR 3  /**< Failures */
+#define LOG_LEVEL_NONE 4   /**< No logging at all */
+
+/** @brief Lowest level compiled in (everything in debug builds, warnings and errors in release builds). */
+#ifndef LOG_LEVEL
+#ifdef NDEBUG
+#define LOG_LEVEL LOG_LEVEL_WARN
+#else
+#define LOG_LEVEL LOG_LEVEL_DEBUG
+#endif
+#endif
+
+/** @brief Most arguments stored by a log call. */
+#define LOG_MAX_ARGS 8
+/** @brief Number of records of the ring (a power of 2). */
+#define LOG_RING_SIZE 1024
+
+/**
+ * @union log_arg_t
+ * @brief Raw argument of a log call, formatted later by the logger thread.
+ */
+typedef union {
+    long long i;       /**< Integers, characters and enums */
+    double d;          /**< Floating point numbers */
+    const void *p;     /**< Strings and pointers */
+} log_arg_t;
+
+static inline log_arg_t log_arg_int(long long value) { return (log_arg_t){.i = value}; }
+static inline log_arg_t log_arg_double(double value) { return (log_arg_t){.d = value}; }
+static inline log_arg_t log_arg_pointer(const void *value) { return (log_arg_t){.p = value}; }
+
+// Only used under if (0): lets the compiler check the arguments against the format
+static inline __attribute__((format(printf, 1, 2))) void log_check_format(const char *format, ...) {
+    (void)format;
+}
+
+/**
+ * @brief Stores a record in the ring.
+ *
+ * Called through the LOG_* macros only.
+ *
+ * @param level Level of the record.
+ * @param file Source file of the call.
+ * @param line Source line of the call.
+ * @param format printf format of the message (kept, not copied).
+ * @param args Raw arguments of the format.
+ * @param arg_count Number of arguments.
+ */
+void logger_log(int level, const char *file, int line, const char *format, const log_arg_t *args, int arg_count);
+
+/**
+ * @brief Starts the logger thread.
+ *
+ * @return 0 on success, -1 if the thread cannot start.
+ */
+int logger_open(void);
+
+/**
+ * @brief Writes the pending records and stops the logger thread.
+ */
+void logger_close(void);
+
+/**
+ * @brief Gets the number of records dropped because the ring was full.
+ *
+ * @return The number of dropped records.
+ */
+unsigned long logger_get_dropped(void);
+
+/*
+ * Argument capture: each argument is converted to a log_arg_t according
+ * to its type, without formatting.
+ */
+#define LOG_ARG(x) _Generic((x),                                             \
+    float: log_arg_double, double: log_arg_double,                         \
+    char *: log_arg_pointer, const char *: log_arg_pointer,                \
+    void *: log_arg_pointer, const void *: log_arg_pointer,                \
+    default: log_arg_int)(x)
+
+#define LOG_ARGS_0(f)
+#define LOG_ARGS_1(f, a) , LOG_ARG(a)
+#define LOG_ARGS_2(f, a, ...) , LOG_ARG(a) LOG_ARGS_1(f, __VA_ARGS__)
+#define LOG_ARGS_3(f, a, ...) , LOG_ARG(a) LOG_ARGS_2(f, __VA_ARGS__)
+#define LOG_ARGS_4(f, a, ...) , LOG_ARG(a) LOG_ARGS_3(f, __VA_ARGS__)
+#define LOG_ARGS_5(f, a, ...) , LOG_ARG(a) LOG_ARGS_4(f, __VA_ARGS__)
+#define LOG_ARGS_6(f, a, ...) , LOG_ARG(a) LOG_ARGS_5(f, __VA_ARGS__)
+#define LOG_ARGS_7(f, a, ...) , LOG_ARG(a) LOG_ARGS_6(f, __VA_ARGS__)
+#define LOG_ARGS_8(f, a, ...) , LOG_ARG(a) LOG_ARGS_7(f, __VA_ARGS__)
+#define LOG_SELECT(f, _1, _2, _3, _4, _5, _6, _7, _8, name, ...) name
+#define LOG_FORMAT(f, ...) f
+
+// Builds the record of a call: the format first, then up to LOG_MAX_ARGS arguments
+#define LOG_AT(level, ...)                                                   \
+    do {                                                                     \
+        if (0) log_check_format(__VA_ARGS__);                                \
+        const log_arg_t log_args_[] = {{0} LOG_SELECT(__VA_ARGS__,           \
+            LOG_ARGS_8, LOG_ARGS_7, LOG_ARGS_6, LOG_ARGS_5, LOG_ARGS_4,      \
+            LOG_ARGS_3, LOG_ARGS_2, LOG_ARGS_1, LOG_ARGS_0, unused)(__VA_ARGS__)}; \
+        logger_log(level, __FILE__, __LINE__, LOG_FORMAT(__VA_ARGS__, unused), \
+                   log_args_ + 1, (int)(sizeof(log_args_) / sizeof(log_args_[0])) - 1); \
+    } while (0)
+
+// Compiled out: the arguments are checked, never evaluated
+#define LOG_OFF(...) do { if (0) log_check_format(__VA_ARGS__); } while (0)
+
+#if LOG_LEVEL <= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(...) LOG_AT(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#else
+#define LOG_DEBUG(...) LOG_OFF(__VA_ARGS__)
+#endif
+
+#if LOG_LEVEL <= LOG_LEVEL_INFO
+#define LOG_INFO(...) LOG_AT(LOG_LEVEL_INFO, __VA_ARGS__)
+#else
+#define LOG_INFO(...) LOG_OFF(__VA_ARGS__)
+#endif
+
+#if LOG_LEVEL <= LOG_LEVEL_WARN
+#define LOG_WARN(...) LOG_AT(LOG_LEVEL_WARN, __VA_ARGS__)
+#else
+#define LOG_WARN(...) LOG_OFF(__VA_ARGS__)
+#endif
+
+#if LOG_LEVEL <= LOG_LEVEL_ERROR
+#define LOG_ERROR(...) LOG_AT(LOG_LEVEL_ERROR, __VA_ARGS__)
+#else
+#define LOG_ERROR(...) LOG_OFF(__VA_ARGS__)
+#endif
+
+#endif // LOGGER_H
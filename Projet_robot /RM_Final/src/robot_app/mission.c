@@ -0,0 +1,294 @@
+#include "mission.h"
+#include <fcntl.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// The records of a binary mission are used in place as move_t
+_Static_assert(sizeof(move_t) == 16, "move_t is the record layout of the binary missions");
+_Static_assert(sizeof(mission_header_t) % sizeof(int) == 0, "the records must stay aligned");
+
+/** @brief Most words on a line of a text mission. */
+#define MAX_WORDS 4
+/** @brief Length of the shortest move of a text mission, "forward 1" and its end of line. */
+#define MIN_MOVE_LENGTH 10
+
+/**
+ * A word of a text mission, not NUL terminated (the mapping may end right after it).
+ */
+typedef struct {
+    const char *start;  // First character
+    size_t length;      // Number of characters
+} word_t;
+
+// Checks the values of a move, gives the reason if it is invalid
+static const char *check_move(const move_t *move) {
+    if (move->speed <= 0 || move->speed > PATH_FULL_SPEED) {
+        return "vitesse hors de 1..100";
+    }
+    switch (move->direction) {
+        case FORWARD:
+            if (move->parameters[0] <= 0 || move->parameters[0] > MISSION_MAX_DISTANCE) {
+                return "distance hors limites";
+            }
+            break;
+        case ROTATION:
+            if (move->parameters[0] != LEFT && move->parameters[0] != RIGHT && move->parameters[0] != U_TURN) {
+                return "sens de rotation inconnu";
+            }
+            break;
+        default:
+            return "type de mouvement inconnu";
+    }
+    if (move->parameters[1] != 0) {
+        return "second paramètre non nul";
+    }
+    return NULL;
+}
+
+// Compares a word with a keyword
+static bool word_is(word_t word, const char *keyword) {
+    return word.length == strlen(keyword) && memcmp(word.start, keyword, word.length) == 0;
+}
+
+// Reads a word as a positive number, -1 if it is not one
+static int word_number(word_t word) {
+    int value = 0;
+
+    if (word.length == 0 || word.length > 9) {  // Cannot overflow an int
+        return -1;
+    }
+    for (size_t i = 0; i < word.length; i++) {
+        if (word.start[i] < '0' || word.start[i] > '9') {
+            return -1;
+        }
+        value = value * 10 + (word.start[i] - '0');
+    }
+    return value;
+}
+
+// Splits a line into words, gives their number (MAX_WORDS + 1 if there are too many)
+static int split_line(const char *line, const char *end, word_t words[MAX_WORDS]) {
+    int count = 0;
+    const char *p = line;
+
+    while (p < end && *p != '#') {
+        if (*p == ' ' || *p == '\t' || *p == '\r') {
+            p++;
+            continue;
+        }
+        if (count == MAX_WORDS) {
+            return MAX_WORDS + 1;
+        }
+        words[count].start = p;
+        while (p < end && *p != ' ' && *p != '\t' && *p != '\r' && *p != '#') {
+            p++;
+        }
+        words[count].length = (size_t)(p - words[count].start);
+        count++;
+    }
+    return count;
+}
+
+// Reads one move of a text mission, gives the reason if it is invalid
+static const char *parse_move(const word_t *words, int count, move_t *move) {
+    *move = (move_t){FORWARD, {0, 0}, PATH_FULL_SPEED};
+
+    if (word_is(words[0], "forward")) {
+        if (count < 2 || count > 3) {
+            return "attendu : forward <distance> [vitesse]";
+        }
+        move->parameters[0] = word_number(words[1]);
+    } else if (word_is(words[0], "rotate")) {
+        if (count < 2 || count > 3) {
+            return "attendu : rotate left|right|u_turn [vitesse]";
+        }
+        move->direction = ROTATION;
+        if (word_is(words[1], "left")) {
+            move->parameters[0] = LEFT;
+        } else if (word_is(words[1], "right")) {
+            move->parameters[0] = RIGHT;
+        } else if (word_is(words[1], "u_turn")) {
+            move->parameters[0] = U_TURN;
+        } else {
+            return "sens de rotation inconnu";
+        }
+    } else {
+        return "type de mouvement inconnu";
+    }
+    if (count == 3) {
+        move->speed = word_number(words[2]);
+    }
+    return check_move(move);
+}
+
+// Parses a text mission into an array of moves
+static int parse_text(const char *filename, const char *text, size_t size, mission_t *mission) {
+    const char *end = text + size;
+    // Bound on the moves, without a first pass over the text: the valid ones, and the invalid one that ends the parsing
+    size_t capacity = (size + 1) / MIN_MOVE_LENGTH + 1;
+    int steps = 0;
+    int line_number = 0;
+
+    if (capacity > MISSION_MAX_STEPS) {
+        capacity = MISSION_MAX_STEPS + 1;  // Enough to detect a mission too long
+    }
+    move_t *moves = malloc(capacity * sizeof(move_t));
+    if (moves == NULL) {
+        perror(filename);
+        return -1;
+    }
+
+    for (const char *line = text; line < end; ) {
+        const char *eol = memchr(line, '\n', (size_t)(end - line));
+        word_t words[MAX_WORDS];
+        const char *error = NULL;
+
+        if (eol == NULL) {
+            eol = end;
+        }
+        line_number++;
+        int count = split_line(line, eol, words);
+        if (count > MAX_WORDS) {
+            error = "trop de mots";
+        } else if (count > 0 && steps == MISSION_MAX_STEPS) {
+            error = "mission trop longue";
+        } else if (count > 0) {
+            error = parse_move(words, count, &moves[steps]);
+            steps++;
+        }
+        if (error != NULL) {
+            fprintf(stderr, "%s:%d : %s\n", filename, line_number, error);
+            free(moves);
+            return -1;
+        }
+        line = eol + 1;
+    }
+    if (steps == 0) {
+        fprintf(stderr, "%s : mission vide\n", filename);
+        free(moves);
+        return -1;
+    }
+
+    mission->parsed = moves;
+    mission->path = (path_t){filename, moves, steps};
+    return 0;
+}
+
+// Validates a binary mission in place
+static int check_binary(const char *filename, const void *map, size_t size, mission_t *mission) {
+    const mission_header_t *header = map;
+
+    // Validate the header before trusting the sizes it gives
+    if (size < sizeof(mission_header_t) || header->version != MISSION_VERSION ||
+        header->record_size != sizeof(move_t) || header->steps == 0 || header->steps > MISSION_MAX_STEPS ||
+        size != sizeof(mission_header_t) + (size_t)header->steps * sizeof(move_t)) {
+        fprintf(stderr, "%s : mission binaire invalide ou de version différente\n", filename);
+        return -1;
+    }
+
+    const move_t *moves = (const move_t *)(header + 1);
+    for (uint32_t i = 0; i < header->steps; i++) {
+        const char *error = check_move(&moves[i]);
+        if (error != NULL) {
+            fprintf(stderr, "%s : mouvement %u : %s\n", filename, (unsigned)i + 1, error);
+            return -1;
+        }
+    }
+    mission->path = (path_t){filename, moves, (int)header->steps};
+    return 0;
+}
+
+// Loads and validates a mission file
+int mission_load(const char *filename, mission_t *mission) {
+    struct stat st;
+    void *map;
+    int fd;
+
+    *mission = (mission_t){{NULL, NULL, 0}, NULL, 0, NULL};
+    fd = open(filename, O_RDONLY);
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        perror(filename);
+        if (fd >= 0) {
+            close(fd);
+        }
+        return -1;
+    }
+    if (st.st_size == 0) {
+        fprintf(stderr, "%s : mission vide\n", filename);
+        close(fd);
+        return -1;
+    }
+    // Populate the pages now so the control loop never takes a page fault on the moves
+    map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        perror(filename);
+        return -1;
+    }
+
+    uint32_t magic = MISSION_MAGIC;
+    if ((size_t)st.st_size >= sizeof(magic) && memcmp(map, &magic, sizeof(magic)) == 0) {
+        if (check_binary(filename, map, (size_t)st.st_size, mission) != 0) {
+            munmap(map, (size_t)st.st_size);
+            return -1;
+        }
+        mission->map = map;  // The path points into the mapping
+        mission->map_size = (size_t)st.st_size;
+        return 0;
+    }
+
+    int result = parse_text(filename, map, (size_t)st.st_size, mission);
+    munmap(map, (size_t)st.st_size);  // The parsed moves are a copy
+    return result;
+}
+
+// Releases a loaded mission
+void mission_unload(mission_t *mission) {
+    if (mission->map != NULL) {
+        munmap(mission->map, mission->map_size);
+    }
+    free(mission->parsed);
+    *mission = (mission_t){{NULL, NULL, 0}, NULL, 0, NULL};
+}
+
+// Writes moves as a binary mission
+int mission_save(const char *filename, const move_t *moves, int steps) {
+    mission_header_t header = {MISSION_MAGIC, MISSION_VERSION, sizeof(move_t), (uint32_t)steps};
+    char temp[PATH_MAX];
+    FILE *file = NULL;
+    int fd = -1;
+
+    // Written aside, then renamed: a mapping of the previous file keeps its pages
+    if (snprintf(temp, sizeof(temp), "%s.%ld.tmp", filename, (long)getpid()) >= (int)sizeof(temp)) {
+        fprintf(stderr, "%s : nom trop long\n", filename);
+        return -1;
+    }
+    fd = open(temp, O_WRONLY | O_CREAT | O_EXCL, 0666);
+    if (fd < 0 || (file = fdopen(fd, "wb")) == NULL) {
+        perror(temp);
+        if (fd >= 0) {
+            close(fd);
+            unlink(temp);
+        }
+        return -1;
+    }
+    if (fwrite(&header, sizeof(header), 1, file) != 1 ||
+        fwrite(moves, sizeof(move_t), (size_t)steps, file) != (size_t)steps) {
+        perror(temp);
+        fclose(file);
+        unlink(temp);
+        return -1;
+    }
+    if (fclose(file) != 0 || rename(temp, filename) != 0) {
+        perror(filename);
+        unlink(temp);
+        return -1;
+    }
+    return 0;
+}
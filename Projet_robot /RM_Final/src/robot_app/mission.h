@@ -0,0 +1,98 @@
+#ifndef MISSION_H
+#define MISSION_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "pilot.h"
+#include "path_registry.h"
+
+/**
+ * @file mission.h
+ * @brief Mission files: paths loaded at run time instead of compiled in.
+ *
+ * A mission is a sequence of moves, written either as text or in a binary
+ * form. The file is mapped in memory and validated once by mission_load();
+ * the moves are then given as a path_t that copilot_set_path() reads
+ * directly, without any copy for a binary mission.
+ *
+ * Text form, one move per line (speed in % of the execution speed,
+ * 100 if omitted; '#' starts a comment):
+ * @code
+ * forward 100 80
+ * rotate right
+ * rotate left 50
+ * rotate u_turn
+ * @endcode
+ *
+ * Binary form: a mission_header_t followed by the move_t records, in the
+ * byte order of the robot (see the mission_compile tool).
+ */
+
+/** @brief Magic number at the start of a binary mission ("MISN"). */
+#define MISSION_MAGIC 0x4E53494Du
+/** @brief Version of the binary layout. */
+#define MISSION_VERSION 1
+/** @brief Largest number of moves in a mission. */
+#define MISSION_MAX_STEPS 1000000
+/** @brief Largest distance of a forward move. */
+#define MISSION_MAX_DISTANCE 10000
+
+/**
+ * @struct mission_header_t
+ * @brief Header at the start of a binary mission.
+ */
+typedef struct {
+    uint32_t magic;       /**< MISSION_MAGIC */
+    uint32_t version;     /**< MISSION_VERSION */
+    uint32_t record_size; /**< sizeof(move_t) */
+    uint32_t steps;       /**< Number of move_t records following the header */
+} mission_header_t;
+
+/**
+ * @struct mission_t
+ * @brief A loaded mission.
+ */
+typedef struct {
+    path_t path;      /**< The validated moves, ready for copilot_set_path() */
+    void *map;        /**< Mapping of a binary mission file (NULL otherwise) */
+    size_t map_size;  /**< Size of the mapping */
+    move_t *parsed;   /**< Moves parsed from a text mission (NULL otherwise) */
+} mission_t;
+
+/**
+ * @brief Loads and validates a mission file, text or binary.
+ *
+ * A binary mission stays mapped and its path points into the mapping; a
+ * text mission is parsed once into an array of moves. Errors are reported
+ * on stderr with the line of the faulty move.
+ *
+ * @param filename The mission file (kept as the name of the path).
+ * @param mission The mission to fill (left empty on error).
+ * @return 0 on success, -1 if the file cannot be read or is invalid.
+ */
+int mission_load(const char *filename, mission_t *mission);
+
+/**
+ * @brief Releases a mission loaded by mission_load().
+ *
+ * Its path must no longer be used by the copilot.
+ *
+ * @param mission The mission to release (may be empty).
+ */
+void mission_unload(mission_t *mission);
+
+/**
+ * @brief Writes moves as a binary mission.
+ *
+ * The moves are written to a temporary file next to the mission, then
+ * renamed over it: a mission still mapped by mission_load() keeps its old
+ * content instead of being truncated under the copilot.
+ *
+ * @param filename The mission file to create.
+ * @param moves The moves.
+ * @param steps The number of moves.
+ * @return 0 on success, -1 on error.
+ */
+int mission_save(const char *filename, const move_t *moves, int steps);
+
+#endif // MISSION_H
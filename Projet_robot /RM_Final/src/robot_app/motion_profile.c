@@ -0,0 +1,85 @@
+#include "motion_profile.h"
+#include <math.h>
+#include "speed_ctrl.h"
+#include "../utils.h"
+
+/** @brief Encoder steps per second for 1 % of speed. */
+#define STEPS_PER_PCT (SPEED_CTRL_MAX_STEPS_PER_S / 100.0)
+
+static motion_profile_config_t config = MOTION_PROFILE_DEFAULT_CONFIG;  // Profile limits
+
+// Sets the limits of the profiles
+void motion_profile_configure(const motion_profile_config_t *new_config) {
+    config = *new_config;
+}
+
+// Gets the limits of the profiles
+motion_profile_config_t motion_profile_get_config(void) {
+    return config;
+}
+
+// Starts the profile of a move
+void motion_profile_start(motion_profile_t *profile, double length_steps, double cruise_pct, double start_pct) {
+    profile->length_steps = length_steps;
+    profile->cruise_pct = fabs(cruise_pct);
+    profile->speed_pct = fmin(fabs(start_pct), profile->cruise_pct);
+    profile->accel_pct_s = 0.0;
+    profile->end_pct = 0.0;
+}
+
+// Sets the speed at which the move hands over to the next one
+void motion_profile_set_end_speed(motion_profile_t *profile, double end_pct) {
+    profile->end_pct = fmin(fabs(end_pct), profile->cruise_pct);
+}
+
+// Highest speed from which the robot can still slow down to end_pct within a distance
+static double braking_speed_pct(double remaining_steps, double end_pct) {
+    double a = config.accel_pct_s * STEPS_PER_PCT;
+    double j = config.jerk_pct_s2 * STEPS_PER_PCT;
+    double end = end_pct * STEPS_PER_PCT;
+    double ramp = a * a / j;  // Speed lost while the deceleration builds up
+
+    // Solves d = (v^2 - end^2) / 2a + v.a / 2j for v
+    return (-ramp + sqrt(ramp * ramp + 4.0 * (2.0 * a * remaining_steps + end * end))) / 2.0 / STEPS_PER_PCT;
+}
+
+// Computes the speed to command for the current tick
+double motion_profile_step(motion_profile_t *profile, double progress_steps) {
+    double remaining = profile->length_steps - progress_steps;
+    double dt = (double)config.period_ns / (double)NS_PER_S;
+
+    if (remaining <= 0.0) {
+        profile->speed_pct = profile->end_pct;
+        profile->accel_pct_s = 0.0;
+        return profile->speed_pct;
+    }
+    if (!config.enabled || dt <= 0.0) {
+        profile->speed_pct = profile->cruise_pct;
+        return profile->speed_pct;
+    }
+
+    // The wheels follow the command with a lag: brake for the distance they will still cover
+    double reachable = remaining - profile->speed_pct * STEPS_PER_PCT * config.lag_s;
+    double goal = fmin(profile->cruise_pct, braking_speed_pct(fmax(reachable, 0.0), profile->end_pct));
+    double wanted = (goal - profile->speed_pct) / dt;
+    double max_change = config.jerk_pct_s2 * dt;
+
+    // Acceleration limited, and reached under the jerk limit unless the
+    // robot is already too fast to stop in time
+    wanted = fmax(-config.accel_pct_s, fmin(config.accel_pct_s, wanted));
+    if (profile->speed_pct > goal && wanted < profile->accel_pct_s - max_change) {
+        profile->accel_pct_s = fmin(profile->accel_pct_s - max_change, fmax(wanted, -config.accel_pct_s));
+        profile->accel_pct_s = fmin(profile->accel_pct_s, 0.0);
+    } else {
+        profile->accel_pct_s += fmax(-max_change, fmin(max_change, wanted - profile->accel_pct_s));
+    }
+    profile->speed_pct += profile->accel_pct_s * dt;
+
+    if (profile->speed_pct > profile->cruise_pct) {
+        profile->speed_pct = profile->cruise_pct;
+        profile->accel_pct_s = 0.0;
+    }
+    // Never stall before the target
+    profile->speed_pct = fmax(profile->speed_pct, fmin(fmax(config.min_speed_pct, profile->end_pct), profile->cruise_pct));
+    return profile->speed_pct;
+}
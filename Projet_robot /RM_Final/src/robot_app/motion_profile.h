@@ -0,0 +1,93 @@
+#ifndef MOTION_PROFILE_H
+#define MOTION_PROFILE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "control_loop.h"
+
+/**
+ * @file motion_profile.h
+ * @brief Jerk and acceleration limited speed profiles for the pilot moves.
+ *
+ * A profile is started with the length of a move (in encoder steps) and
+ * its cruise speed; then motion_profile_step() is called on every control
+ * tick with the progress made so far and gives the speed to command. The
+ * speed ramps up under the acceleration and jerk limits, cruises, and
+ * follows a braking curve computed from the distance remaining, so the
+ * robot reaches the target slowly instead of being stopped at full speed.
+ * Speeds are in % of the wheel speed at a 100 % command.
+ */
+
+/**
+ * @struct motion_profile_config_t
+ * @brief Limits of the motion profiles.
+ */
+typedef struct {
+    bool enabled;         /**< false to jump to the cruise speed and stop at the target as before */
+    double accel_pct_s;   /**< Largest acceleration (in %/s) */
+    double jerk_pct_s2;   /**< Largest change of the acceleration (in %/s^2) */
+    double min_speed_pct; /**< Speed kept until the target is reached (in %) */
+    double lag_s;         /**< Delay of the wheels behind the command, anticipated when braking (in s) */
+    uint64_t period_ns;   /**< Period of the calls to motion_profile_step() (in nanoseconds) */
+} motion_profile_config_t;
+
+/** @brief Default limits, stepped once per tick of the control loop. */
+#define MOTION_PROFILE_DEFAULT_CONFIG {true, 800.0, 8000.0, 15.0, 0.02, CONTROL_PERIOD_NS}
+
+/**
+ * @struct motion_profile_t
+ * @brief State of the profile of one move.
+ */
+typedef struct {
+    double length_steps;  /**< Length of the move (in encoder steps) */
+    double cruise_pct;    /**< Cruise speed (in %) */
+    double speed_pct;     /**< Speed given by the last step (in %) */
+    double accel_pct_s;   /**< Acceleration applied by the last step (in %/s) */
+    double end_pct;       /**< Speed at the end of the move (in %, 0 to stop) */
+} motion_profile_t;
+
+/**
+ * @brief Sets the limits used by the profiles started afterwards.
+ *
+ * @param config The new limits.
+ */
+void motion_profile_configure(const motion_profile_config_t *config);
+
+/**
+ * @brief Gets the limits of the profiles.
+ *
+ * @return The current limits.
+ */
+motion_profile_config_t motion_profile_get_config(void);
+
+/**
+ * @brief Starts the profile of a move.
+ *
+ * @param profile The profile to start.
+ * @param length_steps The length of the move (in encoder steps).
+ * @param cruise_pct The cruise speed (in %).
+ * @param start_pct The speed of the robot at the start (in %, 0 from a standstill).
+ */
+void motion_profile_start(motion_profile_t *profile, double length_steps, double cruise_pct, double start_pct);
+
+/**
+ * @brief Sets the speed at which the move hands over to the next one.
+ *
+ * The braking curve then ends at this speed instead of a standstill
+ * (0 by default when the profile starts).
+ *
+ * @param profile The profile of the move.
+ * @param end_pct The speed at the end of the move (in %).
+ */
+void motion_profile_set_end_speed(motion_profile_t *profile, double end_pct);
+
+/**
+ * @brief Computes the speed to command for the current tick.
+ *
+ * @param profile The profile of the move.
+ * @param progress_steps The distance covered since the start of the move (in encoder steps).
+ * @return The speed to command (in %, never negative; the end speed once the move is done).
+ */
+double motion_profile_step(motion_profile_t *profile, double progress_steps);
+
+#endif // MOTION_PROFILE_H
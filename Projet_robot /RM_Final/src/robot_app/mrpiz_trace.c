@@ -0,0 +1,69 @@
+#include "mrpiz_trace.h"
+#include <pthread.h>
+#include <stdio.h>
+#include "../utils.h"
+
+/** @brief Size of the stdio buffer of the trace file. */
+#define TRACE_BUFFER_SIZE (64 * 1024)
+
+static FILE *trace_file = NULL;  // Open trace (NULL when disabled)
+static uint64_t trace_start_ns;  // Monotonic time of the opening
+static pthread_mutex_t trace_lock = PTHREAD_MUTEX_INITIALIZER; // Calls come from several threads
+
+// Opens a trace file for recording
+int mrpiz_trace_open(const char *path) {
+    mrpiz_trace_header_t header = {
+        MRPIZ_TRACE_MAGIC, MRPIZ_TRACE_VERSION, sizeof(mrpiz_trace_record_t), 0
+    };
+    FILE *file = fopen(path, "wb");
+
+    if (file == NULL) {
+        perror("mrpiz_trace_open");
+        return -1;
+    }
+    setvbuf(file, NULL, _IOFBF, TRACE_BUFFER_SIZE);
+    if (fwrite(&header, sizeof(header), 1, file) != 1) {
+        perror("mrpiz_trace_open");
+        fclose(file);
+        return -1;
+    }
+
+    pthread_mutex_lock(&trace_lock);
+    trace_start_ns = monotonic_ns();
+    __atomic_store_n(&trace_file, file, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&trace_lock);
+    return 0;
+}
+
+// Checks if calls are being recorded
+bool mrpiz_trace_enabled(void) {
+    return __atomic_load_n(&trace_file, __ATOMIC_RELAXED) != NULL;
+}
+
+// Appends one call to the trace
+void mrpiz_trace_log(mrpiz_call_t call, int arg0, int arg1, int ret, uint64_t start_ns, uint64_t end_ns) {
+    pthread_mutex_lock(&trace_lock);
+    if (trace_file != NULL) {
+        mrpiz_trace_record_t record = {
+            .start_ns = start_ns - trace_start_ns,
+            .duration_ns = (uint32_t)(end_ns - start_ns),
+            .call = call,
+            .arg0 = arg0,
+            .arg1 = arg1,
+            .ret = ret,
+            .reserved = 0
+        };
+        fwrite(&record, sizeof(record), 1, trace_file);
+    }
+    pthread_mutex_unlock(&trace_lock);
+}
+
+// Flushes and closes the trace file
+void mrpiz_trace_close(void) {
+    pthread_mutex_lock(&trace_lock);
+    if (trace_file != NULL) {
+        fclose(trace_file);
+        __atomic_store_n(&trace_file, NULL, __ATOMIC_RELAXED);
+    }
+    pthread_mutex_unlock(&trace_lock);
+}
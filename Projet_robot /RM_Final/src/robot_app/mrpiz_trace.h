@@ -0,0 +1,99 @@
+#ifndef MRPIZ_TRACE_H
+#define MRPIZ_TRACE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @file mrpiz_trace.h
+ * @brief Binary trace of the mrpiz calls made through robot.c.
+ *
+ * Recording is enabled at run time with the MRPIZ_TRACE environment
+ * variable (path of the trace file). The trace is replayed without the
+ * simulator by linking the replay backend (make BACKEND=replay) and
+ * giving the trace with the MRPIZ_REPLAY environment variable.
+ */
+
+/** @brief Magic number at the start of a trace ("MRTR"). */
+#define MRPIZ_TRACE_MAGIC 0x5254524Du
+/** @brief Version of the trace layout. */
+#define MRPIZ_TRACE_VERSION 1
+/** @brief Environment variable giving the trace file to record (robot.c). */
+#define MRPIZ_TRACE_ENV "MRPIZ_TRACE"
+/** @brief Environment variable giving the trace file to replay (replay backend). */
+#define MRPIZ_REPLAY_ENV "MRPIZ_REPLAY"
+
+/**
+ * @enum mrpiz_call_t
+ * @brief Identifiers of the traced mrpiz entry points.
+ */
+typedef enum {
+    MRPIZ_CALL_INIT,              /**< mrpiz_init() */
+    MRPIZ_CALL_CLOSE,             /**< mrpiz_close() */
+    MRPIZ_CALL_MOTOR_SET,         /**< mrpiz_motor_set(id, cmd) */
+    MRPIZ_CALL_ENCODER_GET,       /**< mrpiz_motor_encoder_get(id) */
+    MRPIZ_CALL_ENCODER_RESET,     /**< mrpiz_motor_encoder_reset(id) */
+    MRPIZ_CALL_PROXY_SENSOR_GET,  /**< mrpiz_proxy_sensor_get(id) */
+    MRPIZ_CALL_BATTERY_LEVEL,     /**< mrpiz_battery_level() */
+    MRPIZ_CALL_LED_RGB_SET,       /**< mrpiz_led_rgb_set(color) */
+    MRPIZ_CALL_NB                 /**< Number of call identifiers */
+} mrpiz_call_t;
+
+/**
+ * @struct mrpiz_trace_header_t
+ * @brief Header at the start of a trace file.
+ */
+typedef struct {
+    uint32_t magic;       /**< MRPIZ_TRACE_MAGIC */
+    uint32_t version;     /**< MRPIZ_TRACE_VERSION */
+    uint32_t record_size; /**< sizeof(mrpiz_trace_record_t) */
+    uint32_t reserved;    /**< Always 0 */
+} mrpiz_trace_header_t;
+
+/**
+ * @struct mrpiz_trace_record_t
+ * @brief One mrpiz call with its arguments, result and timing.
+ */
+typedef struct {
+    uint64_t start_ns;    /**< Start of the call, relative to the trace opening */
+    uint32_t duration_ns; /**< Duration of the call */
+    int32_t call;         /**< mrpiz_call_t */
+    int32_t arg0;         /**< First argument (identifier or color), 0 if none */
+    int32_t arg1;         /**< Second argument (command), 0 if none */
+    int32_t ret;          /**< Returned value */
+    int32_t reserved;     /**< Always 0 */
+} mrpiz_trace_record_t;
+
+/**
+ * @brief Opens a trace file for recording.
+ *
+ * @param path The trace file to create.
+ * @return 0 on success, -1 on error (recording stays disabled).
+ */
+int mrpiz_trace_open(const char *path);
+
+/**
+ * @brief Checks if calls are being recorded.
+ *
+ * @return true if a trace file is open.
+ */
+bool mrpiz_trace_enabled(void);
+
+/**
+ * @brief Appends one call to the trace (no-op if recording is disabled).
+ *
+ * @param call The call identifier.
+ * @param arg0 The first argument.
+ * @param arg1 The second argument.
+ * @param ret The returned value.
+ * @param start_ns Monotonic time at the start of the call.
+ * @param end_ns Monotonic time at the end of the call.
+ */
+void mrpiz_trace_log(mrpiz_call_t call, int arg0, int arg1, int ret, uint64_t start_ns, uint64_t end_ns);
+
+/**
+ * @brief Flushes and closes the trace file.
+ */
+void mrpiz_trace_close(void);
+
+#endif // MRPIZ_TRACE_H
@@ -0,0 +1,89 @@
+#include "obstacle_model.h"
+#include <math.h>
+#include <pthread.h>
+
+_Static_assert(SENSOR_NB <= 8, "the free sectors fit in a uint8_t");
+
+// Directions of the sensors of the MRPiZ, counterclockwise from the heading
+static const double sensor_angles[SENSOR_NB] = {
+    [SENSOR_LEFT] = 80.0 * M_PI / 180.0,
+    [SENSOR_CENTER_LEFT] = 40.0 * M_PI / 180.0,
+    [SENSOR_CENTER] = 0.0,
+    [SENSOR_CENTER_RIGHT] = -40.0 * M_PI / 180.0,
+    [SENSOR_RIGHT] = -80.0 * M_PI / 180.0
+};
+
+static obstacle_model_t model;  // Model of the last acquisition
+static pthread_mutex_t model_lock = PTHREAD_MUTEX_INITIALIZER; // Shared by control and UI threads
+
+// Gets the direction of a sensor
+double obstacle_model_sensor_angle(sensor_t sensor) {
+    return sensor_angles[sensor];
+}
+
+// Fuses the readings of a status into a model
+void obstacle_model_build(const robot_status_t *status, obstacle_model_t *result) {
+    double weight_sum = 0.0, weighted_angle = 0.0;
+    int run = 0;
+
+    *result = (obstacle_model_t){.nearest = status->sensors[0], .nearest_sensor = SENSOR_LEFT};
+    for (int i = 0; i < SENSOR_NB; i++) {
+        int reading = status->sensors[i];
+
+        if (reading < result->nearest) {
+            result->nearest = reading;
+            result->nearest_sensor = (sensor_t)i;
+        }
+        if (reading > OBSTACLE_FREE_DISTANCE) {
+            result->free_sectors |= (uint8_t)(1u << i);
+            // Widest run of free sectors, the one closest to the front on a tie
+            run++;
+            double middle = (sensor_angles[i - run + 1] + sensor_angles[i]) / 2.0;
+            if (run > result->free_width ||
+                (run == result->free_width && fabs(middle) < fabs(result->free_direction_rad))) {
+                result->free_width = run;
+                result->free_direction_rad = middle;
+            }
+        } else {
+            // The closer the obstacle, the more it pulls the direction
+            double weight = OBSTACLE_FREE_DISTANCE + 1 - (reading > 0 ? reading : 0);
+            weight_sum += weight;
+            weighted_angle += weight * sensor_angles[i];
+            run = 0;
+        }
+    }
+    result->detected = weight_sum > 0.0;
+    result->direction_rad = result->detected ? weighted_angle / weight_sum : 0.0;
+
+    // Obstacles seen on the sides of the front only matter inside the corridor of the robot
+    result->front_distance = status->sensors[SENSOR_CENTER];
+    for (int i = SENSOR_CENTER_LEFT; i <= SENSOR_CENTER_RIGHT; i += SENSOR_CENTER_RIGHT - SENSOR_CENTER_LEFT) {
+        double range = OBSTACLE_SENSOR_OFFSET_MM + status->sensors[i];
+        if (status->sensors[i] <= OBSTACLE_FREE_DISTANCE &&
+            fabs(range * sin(sensor_angles[i])) <= OBSTACLE_CORRIDOR_MM) {
+            int ahead = (int)lround(range * cos(sensor_angles[i])) - OBSTACLE_SENSOR_OFFSET_MM;
+            result->front_distance = ahead < result->front_distance ? ahead : result->front_distance;
+        }
+    }
+}
+
+// Rebuilds the shared model from a new acquisition
+void obstacle_model_update(const robot_status_t *status, uint32_t seq) {
+    obstacle_model_t fresh;
+
+    obstacle_model_build(status, &fresh);
+    fresh.seq = seq;
+    pthread_mutex_lock(&model_lock);
+    model = fresh;
+    pthread_mutex_unlock(&model_lock);
+}
+
+// Gets the model of the last acquisition
+obstacle_model_t obstacle_model_get(void) {
+    obstacle_model_t copy;
+
+    pthread_mutex_lock(&model_lock);
+    copy = model;
+    pthread_mutex_unlock(&model_lock);
+    return copy;
+}
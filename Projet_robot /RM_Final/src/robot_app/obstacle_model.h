@@ -0,0 +1,115 @@
+#ifndef OBSTACLE_MODEL_H
+#define OBSTACLE_MODEL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "robot.h"
+
+/**
+ * @file obstacle_model.h
+ * @brief Obstacles around the robot, fused from the five proximity sensors.
+ *
+ * The model is rebuilt from the filtered readings (see sensor_filter.h) of
+ * each status acquisition (robot_refresh_status()), so the pilot, the
+ * copilot and the wall follower all decide on the same readings and the
+ * same thresholds. Each sensor covers a sector centered on its direction,
+ * and is free when nothing is seen closer than OBSTACLE_FREE_DISTANCE. The
+ * readings of the three front sensors that fall in the corridor swept by
+ * the robot give the free travel ahead: a move may go on while it keeps
+ * OBSTACLE_CLEARANCE from the obstacle. A reading of OBSTACLE_SENSOR_RANGE
+ * means that nothing is seen: the travel ahead is then only known to be
+ * free up to the range.
+ *
+ * Distances are in sensor units, 1 per mm in the native simulator.
+ */
+
+/** @brief Reading of a sensor that sees nothing (its range). */
+#define OBSTACLE_SENSOR_RANGE 255
+/** @brief Reading above which a sector is free. */
+#define OBSTACLE_FREE_DISTANCE 150
+/** @brief Smallest distance kept between the robot and an obstacle ahead (the overshoot of a stop). */
+#define OBSTACLE_CLEARANCE 10
+/** @brief Distance from the robot center to the proximity sensors (in mm). */
+#define OBSTACLE_SENSOR_OFFSET_MM 35
+/** @brief Half width of the corridor swept by the robot moving forward (in mm, its radius). */
+#define OBSTACLE_CORRIDOR_MM 35
+
+/**
+ * @struct obstacle_model_t
+ * @brief Obstacles seen by one status acquisition.
+ */
+typedef struct {
+    uint32_t seq;               /**< Snapshot sequence number of the readings (0 if none yet) */
+    int nearest;                /**< Nearest reading of all the sensors */
+    sensor_t nearest_sensor;    /**< Sensor of the nearest reading */
+    bool detected;              /**< true if a sector is not free */
+    double direction_rad;       /**< Direction of the obstacles, counterclockwise from the heading (0 if none) */
+    uint8_t free_sectors;       /**< Bit i set if the sector of sensor i is free */
+    int free_width;             /**< Number of sectors of the widest free opening (0 if none) */
+    double free_direction_rad;  /**< Middle of the widest free opening (0 if none) */
+    int front_distance;         /**< Free travel straight ahead, front of the robot to the nearest obstacle in its corridor
+                                     (OBSTACLE_SENSOR_RANGE or more if none is seen) */
+} obstacle_model_t;
+
+/**
+ * @brief Gets the direction of a sensor.
+ *
+ * @param sensor The sensor.
+ * @return Its direction, counterclockwise from the heading (in radians).
+ */
+double obstacle_model_sensor_angle(sensor_t sensor);
+
+/**
+ * @brief Fuses the readings of a status into a model.
+ *
+ * @param status The status.
+ * @param model Where to store the model.
+ */
+void obstacle_model_build(const robot_status_t *status, obstacle_model_t *model);
+
+/**
+ * @brief Rebuilds the shared model from a new acquisition.
+ *
+ * Called by robot_refresh_status().
+ *
+ * @param status The status just acquired.
+ * @param seq Its snapshot sequence number.
+ */
+void obstacle_model_update(const robot_status_t *status, uint32_t seq);
+
+/**
+ * @brief Gets the model of the last acquisition.
+ *
+ * @return A copy of the model.
+ */
+obstacle_model_t obstacle_model_get(void);
+
+/**
+ * @brief Tells whether the robot can move forward without coming too close to an obstacle.
+ *
+ * Nothing seen ahead lets any travel go on: the part of it beyond the
+ * range is checked later, as the robot comes closer.
+ *
+ * @param model The model.
+ * @param distance The distance to travel (sensor units).
+ * @return true if OBSTACLE_CLEARANCE is kept at the end of the travel, or of its part within the range.
+ */
+static inline bool obstacle_model_can_advance(const obstacle_model_t *model, double distance) {
+    if (model->front_distance >= OBSTACLE_SENSOR_RANGE) {
+        return true;
+    }
+    return model->front_distance > (distance < OBSTACLE_SENSOR_RANGE ? distance : OBSTACLE_SENSOR_RANGE) + OBSTACLE_CLEARANCE;
+}
+
+/**
+ * @brief Tells whether the sector of a sensor is free.
+ *
+ * @param model The model.
+ * @param sensor The sensor.
+ * @return true if nothing is seen closer than OBSTACLE_FREE_DISTANCE.
+ */
+static inline bool obstacle_model_is_free(const obstacle_model_t *model, sensor_t sensor) {
+    return (model->free_sectors >> sensor) & 1u;
+}
+
+#endif // OBSTACLE_MODEL_H
@@ -0,0 +1,178 @@
+#include "occupancy_grid.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "robot.h"
+#include "odometry.h"
+#include "obstacle_model.h"
+#include "../utils.h"
+
+/** @brief Number of tiles on each side of the grid. */
+#define TILES (OCC_GRID_SIZE / OCC_GRID_TILE)
+/** @brief One in the fixed point directions of the rays. */
+#define TRIG_ONE 16384
+
+_Static_assert(OCC_GRID_SIZE % OCC_GRID_TILE == 0, "the grid is made of whole tiles");
+_Static_assert(OCC_GRID_TILE * OCC_GRID_TILE == 64, "a tile fills one cache line");
+_Static_assert(OCC_GRID_LOG_ODDS_MAX + OCC_GRID_LOG_ODDS_HIT <= INT8_MAX, "saturated in an int8_t");
+
+static _Alignas(64) int8_t cells[OCC_GRID_SIZE * OCC_GRID_SIZE];  // Log-odds, tile after tile
+static int32_t origin_x = -OCC_GRID_SIZE * OCC_GRID_CELL_MM / 2;   // Corner of cell (0, 0) (in mm)
+static int32_t origin_y = -OCC_GRID_SIZE * OCC_GRID_CELL_MM / 2;
+static occupancy_grid_stats_t stats;  // Cost of the updates
+
+// Position of a cell in the tiled storage
+static inline size_t cell_index(int cx, int cy) {
+    size_t tile = (size_t)(cy / OCC_GRID_TILE) * TILES + (size_t)(cx / OCC_GRID_TILE);
+    return tile * OCC_GRID_TILE * OCC_GRID_TILE + (size_t)(cy % OCC_GRID_TILE) * OCC_GRID_TILE + (size_t)(cx % OCC_GRID_TILE);
+}
+
+// Checks that a cell is inside the grid
+static inline bool in_grid(int cx, int cy) {
+    return cx >= 0 && cy >= 0 && cx < OCC_GRID_SIZE && cy < OCC_GRID_SIZE;
+}
+
+// Cell containing a coordinate relative to the grid origin (rounded down)
+static inline int mm_to_cell(int32_t mm) {
+    return mm >= 0 ? mm / OCC_GRID_CELL_MM : -1 - (-mm - 1) / OCC_GRID_CELL_MM;
+}
+
+// Adds a log-odds to a cell, with saturation
+static inline void add_log_odds(int cx, int cy, int delta) {
+    int8_t *cell = &cells[cell_index(cx, cy)];
+    int value = *cell + delta;
+
+    if (value > OCC_GRID_LOG_ODDS_MAX) {
+        value = OCC_GRID_LOG_ODDS_MAX;
+    } else if (value < -OCC_GRID_LOG_ODDS_MAX) {
+        value = -OCC_GRID_LOG_ODDS_MAX;
+    }
+    *cell = (int8_t)value;
+}
+
+// Casts one reading: the cells crossed become free, the last one occupied if something was seen
+static uint32_t cast_ray(int32_t x_mm, int32_t y_mm, double angle, int reading) {
+    int32_t dx_q = (int32_t)lround(cos(angle) * TRIG_ONE);
+    int32_t dy_q = (int32_t)lround(sin(angle) * TRIG_ONE);
+    bool hit = reading < OCC_GRID_SENSOR_RANGE;
+    int32_t length = reading < 0 ? 0 : (hit ? reading : OCC_GRID_SENSOR_RANGE);
+    uint32_t count = 0;
+
+    // Sensor and end of the ray, then Bresenham from cell to cell
+    int32_t sx = x_mm + OCC_GRID_SENSOR_OFFSET_MM * dx_q / TRIG_ONE;
+    int32_t sy = y_mm + OCC_GRID_SENSOR_OFFSET_MM * dy_q / TRIG_ONE;
+    int cx = mm_to_cell(sx), cy = mm_to_cell(sy);
+    int ex = mm_to_cell(sx + length * dx_q / TRIG_ONE), ey = mm_to_cell(sy + length * dy_q / TRIG_ONE);
+    int step_x = ex > cx ? 1 : -1, step_y = ey > cy ? 1 : -1;
+    int dx = abs(ex - cx), dy = -abs(ey - cy);
+    int error = dx + dy;
+
+    while (in_grid(cx, cy) && count < OCC_GRID_MAX_RAY_CELLS) {
+        count++;
+        if (cx == ex && cy == ey) {
+            add_log_odds(cx, cy, hit ? OCC_GRID_LOG_ODDS_HIT : OCC_GRID_LOG_ODDS_MISS);
+            break;
+        }
+        add_log_odds(cx, cy, OCC_GRID_LOG_ODDS_MISS);
+        int twice = 2 * error;
+        if (twice >= dy) {
+            error += dy;
+            cx += step_x;
+        }
+        if (twice <= dx) {
+            error += dx;
+            cy += step_y;
+        }
+    }
+    return count;
+}
+
+// Forgets the map and places the grid
+void occupancy_grid_reset(double origin_x_mm, double origin_y_mm) {
+    memset(cells, 0, sizeof(cells));
+    origin_x = (int32_t)lround(origin_x_mm);
+    origin_y = (int32_t)lround(origin_y_mm);
+    stats = (occupancy_grid_stats_t){0, 0, 0, 0, 0};
+}
+
+// Adds the readings of the last snapshot, seen from the odometry pose
+void occupancy_grid_update(void) {
+    uint64_t start = monotonic_ns();
+    robot_status_t status = robot_get_status();
+    odometry_pose_t pose = odometry_get_pose();
+    int32_t x = (int32_t)lround(pose.x_mm) - origin_x;
+    int32_t y = (int32_t)lround(pose.y_mm) - origin_y;
+    uint32_t count = 0;
+
+    for (int i = 0; i < SENSOR_NB; i++) {
+        count += cast_ray(x, y, pose.theta_rad + obstacle_model_sensor_angle((sensor_t)i), status.sensors[i]);
+    }
+
+    uint64_t elapsed = monotonic_ns() - start;
+    stats.updates++;
+    stats.cells += count;
+    stats.total_ns += elapsed;
+    if (count > stats.max_cells) {
+        stats.max_cells = count;
+    }
+    if (elapsed > stats.max_update_ns) {
+        stats.max_update_ns = elapsed;
+    }
+}
+
+// Gets the cell containing a position
+bool occupancy_grid_to_cell(double x_mm, double y_mm, int *cx, int *cy) {
+    *cx = (int)floor((x_mm - origin_x) / OCC_GRID_CELL_MM);
+    *cy = (int)floor((y_mm - origin_y) / OCC_GRID_CELL_MM);
+    return in_grid(*cx, *cy);
+}
+
+// Gets the center of a cell
+void occupancy_grid_to_position(int cx, int cy, double *x_mm, double *y_mm) {
+    *x_mm = origin_x + (cx + 0.5) * OCC_GRID_CELL_MM;
+    *y_mm = origin_y + (cy + 0.5) * OCC_GRID_CELL_MM;
+}
+
+// Gets the log-odds of a cell
+int occupancy_grid_log_odds(int cx, int cy) {
+    return in_grid(cx, cy) ? cells[cell_index(cx, cy)] : 0;
+}
+
+// Tells whether a cell is free or occupied
+cell_state_t occupancy_grid_cell_state(int cx, int cy) {
+    int log_odds = occupancy_grid_log_odds(cx, cy);
+
+    if (log_odds >= OCC_GRID_OCCUPIED_THRESHOLD) {
+        return CELL_OCCUPIED;
+    }
+    return log_odds <= OCC_GRID_FREE_THRESHOLD ? CELL_FREE : CELL_UNKNOWN;
+}
+
+// Tells whether the cell containing a position is free or occupied
+cell_state_t occupancy_grid_state_at(double x_mm, double y_mm) {
+    int cx, cy;
+
+    if (!occupancy_grid_to_cell(x_mm, y_mm, &cx, &cy)) {
+        return CELL_UNKNOWN;
+    }
+    return occupancy_grid_cell_state(cx, cy);
+}
+
+// Gets the cost of the updates
+occupancy_grid_stats_t occupancy_grid_get_stats(void) {
+    return stats;
+}
+
+// Prints the cost of the updates and the number of known cells
+void occupancy_grid_print_stats(void) {
+    unsigned long free_cells = 0, occupied_cells = 0;
+
+    for (size_t i = 0; i < sizeof(cells); i++) {
+        free_cells += cells[i] <= OCC_GRID_FREE_THRESHOLD;
+        occupied_cells += cells[i] >= OCC_GRID_OCCUPIED_THRESHOLD;
+    }
+    printf("Carte : %lu mises à jour, %u cellules au plus (%.1f us au plus), %lu cellules libres, %lu occupées\n",
+           (unsigned long)stats.updates, (unsigned)stats.max_cells, (double)stats.max_update_ns / 1e3,
+           free_cells, occupied_cells);
+}
@@ -0,0 +1,148 @@
+#ifndef OCCUPANCY_GRID_H
+#define OCCUPANCY_GRID_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "obstacle_model.h"
+
+/**
+ * @file occupancy_grid.h
+ * @brief Occupancy grid built from the proximity sensors and the odometry pose.
+ *
+ * occupancy_grid_update() is called once per control tick, after the
+ * odometry: each proximity reading is cast as a ray from the estimated
+ * pose of its sensor. The cells crossed by the ray become more likely
+ * free, the cell where it hits an obstacle more likely occupied.
+ *
+ * Each cell holds a log-odds in fixed point (int8_t, 1/16 nat per unit),
+ * so an update is an integer addition with saturation. The cells are
+ * stored by tiles of 8 x 8 (64 bytes, one cache line), so a ray and the
+ * neighbourhood of a cell touch few cache lines. A ray covers at most
+ * OCC_GRID_MAX_RAY_CELLS cells: the cost of an update is bounded.
+ *
+ * The grid is written by the control thread only. Readers may see a
+ * tick half applied, each cell being read atomically.
+ */
+
+/** @brief Side of a cell (in mm). */
+#define OCC_GRID_CELL_MM 10
+/** @brief Number of cells on each side of the grid (multiple of OCC_GRID_TILE). */
+#define OCC_GRID_SIZE 256
+/** @brief Number of cells on each side of a tile. */
+#define OCC_GRID_TILE 8
+/** @brief Sensor value from which nothing is seen (1 unit per mm, as the native simulator). */
+#define OCC_GRID_SENSOR_RANGE 255
+/** @brief Distance from the robot center to the proximity sensors (in mm). */
+#define OCC_GRID_SENSOR_OFFSET_MM OBSTACLE_SENSOR_OFFSET_MM
+/** @brief Largest number of cells updated by one reading. */
+#define OCC_GRID_MAX_RAY_CELLS ((OCC_GRID_SENSOR_OFFSET_MM + OCC_GRID_SENSOR_RANGE) / OCC_GRID_CELL_MM + 2)
+
+/** @brief Log-odds added to the cell where a ray hits an obstacle (1/16 nat). */
+#define OCC_GRID_LOG_ODDS_HIT 24
+/** @brief Log-odds added to the cells crossed by a ray (1/16 nat). */
+#define OCC_GRID_LOG_ODDS_MISS -6
+/** @brief Saturation of the log-odds, so a cell can still change its mind. */
+#define OCC_GRID_LOG_ODDS_MAX 96
+/** @brief Log-odds from which a cell is occupied. */
+#define OCC_GRID_OCCUPIED_THRESHOLD 32
+/** @brief Log-odds under which a cell is free. */
+#define OCC_GRID_FREE_THRESHOLD -12
+
+/**
+ * @enum cell_state_t
+ * @brief What is known about a cell.
+ */
+typedef enum {
+    CELL_UNKNOWN,  /**< Not seen enough (or outside of the grid) */
+    CELL_FREE,     /**< Most likely free */
+    CELL_OCCUPIED  /**< Most likely occupied */
+} cell_state_t;
+
+/**
+ * @struct occupancy_grid_stats_t
+ * @brief Cost of the grid updates.
+ */
+typedef struct {
+    uint64_t updates;        /**< Number of calls to occupancy_grid_update() */
+    uint64_t cells;          /**< Number of cell updates */
+    uint32_t max_cells;      /**< Most cell updates in one call */
+    uint64_t total_ns;       /**< Time spent in the calls (in nanoseconds) */
+    uint64_t max_update_ns;  /**< Longest call (in nanoseconds) */
+} occupancy_grid_stats_t;
+
+/**
+ * @brief Forgets the map and places the grid.
+ *
+ * By default the grid is centered on the start pose of the odometry.
+ *
+ * @param origin_x_mm The x position of the corner of cell (0, 0) (in mm).
+ * @param origin_y_mm The y position of the corner of cell (0, 0) (in mm).
+ */
+void occupancy_grid_reset(double origin_x_mm, double origin_y_mm);
+
+/**
+ * @brief Adds the readings of the last snapshot, seen from the odometry pose.
+ */
+void occupancy_grid_update(void);
+
+/**
+ * @brief Gets the cell containing a position.
+ *
+ * @param x_mm The x position (in mm).
+ * @param y_mm The y position (in mm).
+ * @param cx Where to store the column of the cell.
+ * @param cy Where to store the row of the cell.
+ * @return true if the position is inside the grid.
+ */
+bool occupancy_grid_to_cell(double x_mm, double y_mm, int *cx, int *cy);
+
+/**
+ * @brief Gets the center of a cell.
+ *
+ * @param cx The column of the cell.
+ * @param cy The row of the cell.
+ * @param x_mm Where to store the x position (in mm).
+ * @param y_mm Where to store the y position (in mm).
+ */
+void occupancy_grid_to_position(int cx, int cy, double *x_mm, double *y_mm);
+
+/**
+ * @brief Gets the log-odds of a cell.
+ *
+ * @param cx The column of the cell.
+ * @param cy The row of the cell.
+ * @return The log-odds (1/16 nat), 0 outside of the grid.
+ */
+int occupancy_grid_log_odds(int cx, int cy);
+
+/**
+ * @brief Tells whether a cell is free or occupied.
+ *
+ * @param cx The column of the cell.
+ * @param cy The row of the cell.
+ * @return The state of the cell, CELL_UNKNOWN outside of the grid.
+ */
+cell_state_t occupancy_grid_cell_state(int cx, int cy);
+
+/**
+ * @brief Tells whether the cell containing a position is free or occupied.
+ *
+ * @param x_mm The x position (in mm).
+ * @param y_mm The y position (in mm).
+ * @return The state of the cell, CELL_UNKNOWN outside of the grid.
+ */
+cell_state_t occupancy_grid_state_at(double x_mm, double y_mm);
+
+/**
+ * @brief Gets the cost of the updates since the last reset.
+ *
+ * @return A copy of the statistics.
+ */
+occupancy_grid_stats_t occupancy_grid_get_stats(void);
+
+/**
+ * @brief Prints the cost of the updates and the number of known cells.
+ */
+void occupancy_grid_print_stats(void);
+
+#endif // OCCUPANCY_GRID_H
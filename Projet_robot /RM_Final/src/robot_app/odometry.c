@@ -0,0 +1,74 @@
+#include "odometry.h"
+#include <math.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include "robot.h"
+#include "mrpiz.h"
+#include "../utils.h"
+
+static odometry_pose_t pose;           // Estimated pose
+static pthread_mutex_t pose_lock = PTHREAD_MUTEX_INITIALIZER; // Shared by control and UI threads
+static int last_encoder[2];            // Encoder values integrated last
+static uint32_t last_resets;           // Encoder reset counter integrated last
+static bool primed = false;            // true once last_encoder is valid
+
+// Integrates the encoder deltas of the last snapshot
+void odometry_update(uint64_t period_ns) {
+    robot_snapshot_t snap = robot_get_snapshot();
+    int encoder[2] = {snap.status.left_encoder, snap.status.right_encoder};
+    int delta[2];
+
+    if (!primed) {
+        delta[0] = delta[1] = 0;
+    } else if (snap.encoder_resets != last_resets) {
+        // The encoders restarted from 0: everything they count was done since
+        delta[0] = encoder[0];
+        delta[1] = encoder[1];
+    } else {
+        delta[0] = encoder[0] - last_encoder[0];
+        delta[1] = encoder[1] - last_encoder[1];
+    }
+    last_encoder[0] = encoder[0];
+    last_encoder[1] = encoder[1];
+    last_resets = snap.encoder_resets;
+    primed = true;
+
+    double left = delta[0] * ODOMETRY_MM_PER_STEP;
+    double right = delta[1] * ODOMETRY_MM_PER_STEP;
+    double ds = (left + right) / 2.0;
+    double dtheta = (right - left) / ODOMETRY_WHEEL_BASE_MM;
+    double dt = (double)period_ns / (double)NS_PER_S;
+
+    pthread_mutex_lock(&pose_lock);
+    // Midpoint approximation of the arc travelled during the tick
+    double heading = pose.theta_rad + dtheta / 2.0;
+    pose.x_mm += ds * cos(heading);
+    pose.y_mm += ds * sin(heading);
+    pose.theta_rad = remainder(pose.theta_rad + dtheta, 2.0 * M_PI);
+    pose.distance_mm += fabs(ds);
+    pose.v_mm_s = dt > 0 ? ds / dt : 0.0;
+    pose.omega_rad_s = dt > 0 ? dtheta / dt : 0.0;
+    pose.seq = snap.seq;
+    pthread_mutex_unlock(&pose_lock);
+}
+
+// Gets a copy of the estimated pose
+odometry_pose_t odometry_get_pose(void) {
+    odometry_pose_t copy;
+    pthread_mutex_lock(&pose_lock);
+    copy = pose;
+    pthread_mutex_unlock(&pose_lock);
+    return copy;
+}
+
+// Sets the estimated pose
+void odometry_set_pose(double x_mm, double y_mm, double theta_rad) {
+    pthread_mutex_lock(&pose_lock);
+    pose = (odometry_pose_t){
+        .x_mm = x_mm,
+        .y_mm = y_mm,
+        .theta_rad = remainder(theta_rad, 2.0 * M_PI),
+        .seq = pose.seq
+    };
+    pthread_mutex_unlock(&pose_lock);
+}
@@ -0,0 +1,70 @@
+#ifndef ODOMETRY_H
+#define ODOMETRY_H
+
+#include <math.h>
+#include <stdint.h>
+#include "mrpiz.h"
+
+/**
+ * @file odometry.h
+ * @brief Pose estimation by integration of the wheel encoders.
+ *
+ * odometry_update() is called once per control tick, right after the
+ * status acquisition, and integrates the encoder deltas since the previous
+ * tick (midpoint arc approximation, O(1), no allocation). Encoder resets
+ * are detected with the reset counter of the snapshot: the counts made
+ * since the reset are integrated and the pose is kept.
+ *
+ * The pose starts at (0, 0, 0): x along the initial heading, y to the
+ * left, theta counterclockwise.
+ */
+
+/** @brief Distance between the two wheels (in mm). */
+#define ODOMETRY_WHEEL_BASE_MM 75.0
+/** @brief Diameter of the wheels (in mm). */
+#define ODOMETRY_WHEEL_DIAMETER_MM 32.0
+/** @brief Distance travelled by a wheel for one encoder step (in mm). */
+#define ODOMETRY_MM_PER_STEP (M_PI * ODOMETRY_WHEEL_DIAMETER_MM / MRPIZ_ENCODE_PER_TURN)
+
+/**
+ * @struct odometry_pose_t
+ * @brief Estimated pose and velocity of the robot.
+ */
+typedef struct {
+    double x_mm;            /**< Position along the initial heading (in mm) */
+    double y_mm;            /**< Position to the left of the initial heading (in mm) */
+    double theta_rad;       /**< Heading, counterclockwise, in ]-pi, pi] (in radians) */
+    double v_mm_s;          /**< Linear velocity (in mm/s) */
+    double omega_rad_s;     /**< Angular velocity (in rad/s) */
+    double distance_mm;     /**< Distance travelled by the robot center */
+    uint32_t seq;           /**< Sequence number of the snapshot integrated last */
+} odometry_pose_t;
+
+/**
+ * @brief Integrates the encoder deltas of the last snapshot.
+ *
+ * Must be called once per control tick, after robot_refresh_status().
+ *
+ * @param period_ns The control tick period, used for the velocities (in nanoseconds).
+ */
+void odometry_update(uint64_t period_ns);
+
+/**
+ * @brief Gets a copy of the estimated pose.
+ *
+ * Can be called from any thread.
+ *
+ * @return The last estimated pose.
+ */
+odometry_pose_t odometry_get_pose(void);
+
+/**
+ * @brief Sets the estimated pose (velocities and distance restart from 0).
+ *
+ * @param x_mm The x position (in mm).
+ * @param y_mm The y position (in mm).
+ * @param theta_rad The heading (in radians).
+ */
+void odometry_set_pose(double x_mm, double y_mm, double theta_rad);
+
+#endif // ODOMETRY_H
@@ -0,0 +1,37 @@
+#include "path_registry.h"
+#include <stddef.h>
+
+#define STEP_FORWARD {FORWARD, {PATH_DISTANCE, 0}, PATH_FULL_SPEED}
+#define STEP_RIGHT {ROTATION, {RIGHT, 0}, PATH_FULL_SPEED}
+#define STEP_LEFT {ROTATION, {LEFT, 0}, PATH_FULL_SPEED}
+#define STEP_U_TURN {ROTATION, {U_TURN, 0}, PATH_FULL_SPEED}
+
+// Forward moves alternating right and left turns
+static const move_t zigzag[] = {
+    STEP_FORWARD, STEP_RIGHT, STEP_FORWARD, STEP_LEFT,
+    STEP_FORWARD, STEP_RIGHT, STEP_FORWARD, STEP_LEFT,
+    STEP_FORWARD, STEP_RIGHT, STEP_FORWARD, STEP_LEFT
+};
+static const move_t forward[] = {STEP_FORWARD};
+static const move_t right[] = {STEP_RIGHT};
+static const move_t left[] = {STEP_LEFT};
+static const move_t u_turn[] = {STEP_U_TURN};
+
+#define PATH(name, moves) {name, moves, (int)(sizeof(moves) / sizeof((moves)[0]))}
+
+static const path_t paths[PATH_ID_NB] = {
+    [PATH_ID_1] = PATH("path1", zigzag),
+    [PATH_ID_2] = PATH("path2", zigzag),
+    [PATH_ID_FORWARD] = PATH("forward", forward),
+    [PATH_ID_RIGHT] = PATH("right", right),
+    [PATH_ID_LEFT] = PATH("left", left),
+    [PATH_ID_U_TURN] = PATH("u_turn", u_turn)
+};
+
+// Gets a predefined path
+const path_t *path_registry_get(path_id_t id) {
+    if ((unsigned int)id >= PATH_ID_NB) {
+        return NULL;
+    }
+    return &paths[id];
+}
@@ -0,0 +1,53 @@
+#ifndef PATH_REGISTRY_H
+#define PATH_REGISTRY_H
+
+#include "pilot.h"
+
+/**
+ * @file path_registry.h
+ * @brief Read-only table of the predefined paths.
+ *
+ * The paths are const tables initialised at compile time: they only hold
+ * the geometry of the moves, and the speed of each move is a percentage
+ * of the speed chosen when the path is executed (see copilot_set_speed()).
+ * Nothing is ever written to them, so they can be shared by all threads.
+ */
+
+/** @brief Distance of each forward move of the predefined paths. */
+#define PATH_DISTANCE 100
+/** @brief Speed of a move running at the execution speed (in % of it). */
+#define PATH_FULL_SPEED 100
+
+/**
+ * @enum path_id_t
+ * @brief Identifiers of the predefined paths.
+ */
+typedef enum {
+    PATH_ID_1,        /**< Forward moves alternating right and left turns */
+    PATH_ID_2,        /**< Same geometry as PATH_ID_1 */
+    PATH_ID_FORWARD,  /**< One forward move */
+    PATH_ID_RIGHT,    /**< One right turn */
+    PATH_ID_LEFT,     /**< One left turn */
+    PATH_ID_U_TURN,   /**< One U-turn */
+    PATH_ID_NB        /**< Number of predefined paths */
+} path_id_t;
+
+/**
+ * @struct path_t
+ * @brief A path: a sequence of moves.
+ */
+typedef struct {
+    const char *name;     /**< Name of the path */
+    const move_t *moves;  /**< The moves, speeds in % of the execution speed */
+    int steps;            /**< Number of moves */
+} path_t;
+
+/**
+ * @brief Gets a predefined path.
+ *
+ * @param id The path identifier.
+ * @return The path, NULL if the identifier is unknown.
+ */
+const path_t *path_registry_get(path_id_t id);
+
+#endif // PATH_REGISTRY_H
@@ -1,35 +1,89 @@
 #include "pilot.h"
 #include "robot.h"
+#include "speed_ctrl.h"
+#include "motion_profile.h"
+#include "obstacle_model.h"
+#include "odometry.h"
+#include "logger.h"
 #include "mrpiz.h"
-#include <stdio.h>
-#include <unistd.h>
+#include <math.h>
+#include <stdlib.h>
 #include <stdbool.h>
 
 #define U_TURN_TARGET_POS 456  // U-turn duration
 #define DEFAULT_TARGET_POS 200  // Default target position
-#define OBSTACLE_DISTANCE_THRESHOLD 150  // Obstacle distance threshold
+
+#define WALL_SPEED 30  // Wheel speed used while following the wall
+#define WALL_TURN_TARGET_POS 100  // Encoder travel of a wall-following turn (former 500 ms wait)
+#define WALL_BACK_UP_TARGET_POS 100  // Encoder travel when backing out of a dead angle (former 500 ms wait)
+#define WALL_U_TURN_TARGET_POS 200  // Encoder travel of the forced U-turn (former 1 s wait)
+#define WALL_MANEUVER_TIMEOUT_NS 2000000000ULL  // Give up a maneuver if the wheels are blocked
+
+/**
+ * States of the wall-following state machine.
+ */
+typedef enum {
+    WALL_DECIDE,      // Read the sensors and choose the next maneuver
+    WALL_TURN,        // Turning right or left towards a free side
+    WALL_DEAD_ANGLE,  // Forced left turn out of a dead angle
+    WALL_BACK_UP,     // Still blocked: moving backward
+    WALL_U_TURN       // Still blocked: turning around
+} wall_state_t;
 
 static move_status_t robot_moving;  // Current movement status of the robot
 static int target_pos;  // Movement duration 2D 228
+static int dir_left, dir_right;  // Direction of each wheel during the move (-1, 0 or 1)
+static motion_profile_t profile;  // Speed profile of the current move
+static double carried_speed;  // Speed handed over by the previous move (0 after a stop)
+static bool reversing;  // true while the backward wheel of a blended rotation still catches up with the profile
+static double reversal_pct;  // Speed of that wheel, counted in its direction of the rotation (in %)
+static uint64_t hold_deadline_ns;  // Snapshot time after which a held move fails
+
+static wall_state_t wall_state = WALL_DECIDE;  // Current wall-following state
+static int maneuver_start_pos;  // Left encoder value at the start of the maneuver
+static uint64_t maneuver_deadline_ns;  // Snapshot time after which the maneuver ends
+
+// Commands the wheels at the profile speed; after a blended handover, the wheel that turns
+// backwards in the rotation is brought from its forward speed down through 0 under the
+// acceleration limit, instead of being reversed at once
+static void command_wheels(speed_pct_t speed) {
+    speed_pct_t left = (speed_pct_t)(dir_left * speed);
+    speed_pct_t right = (speed_pct_t)(dir_right * speed);
+
+    if (reversing) {
+        motion_profile_config_t config = motion_profile_get_config();
+        reversal_pct += config.accel_pct_s * (double)config.period_ns / (double)NS_PER_S;
+        if (reversal_pct >= speed) {
+            reversing = false;  // Caught up: both wheels follow the profile
+        } else if (dir_left < 0) {
+            left = (speed_pct_t)-lround(reversal_pct);
+        } else {
+            right = (speed_pct_t)-lround(reversal_pct);
+        }
+    }
+    speed_ctrl_set_target(left, right);
+}
 
 // Function to start the robot's movement based on the given move direction and speed
 void pilot_start_move(move_t a_move) {
     int speed_left = 0, speed_right = 0;
+    speed_pct_t speed;
 
     // Determine the movement direction and set the speeds accordingly
     switch (a_move.direction) {
         case FORWARD:
-            printf("FORWARD\n");
+            LOG_DEBUG("FORWARD\n");
             speed_left = a_move.speed;
             speed_right = a_move.speed;
             robot_moving = MOVE_FORWARDING;
+            target_pos = a_move.parameters[0] * FORWARD_STEPS_PER_DISTANCE;
             break;
 
         case ROTATION:
             // Determine the rotation direction and set the speeds accordingly
             switch (a_move.parameters[0]) {
                 case RIGHT:
-                    printf("RIGHT\n");
+                    LOG_DEBUG("RIGHT\n");
                     speed_left = a_move.speed;
                     speed_right = -a_move.speed;
                     robot_moving = MOVE_TURNING;
@@ -38,7 +92,7 @@ void pilot_start_move(move_t a_move) {
                     break;
 
                 case LEFT:
-                    printf("LEFT\n");
+                    LOG_DEBUG("LEFT\n");
                     speed_left = -a_move.speed;
                     speed_right = a_move.speed;
                     robot_moving = MOVE_TURNING;
@@ -46,7 +100,7 @@ void pilot_start_move(move_t a_move) {
                     break;
 
                 case U_TURN:
-                    printf("U_TURN\n");
+                    LOG_DEBUG("U_TURN\n");
                     speed_left = a_move.speed;
                     speed_right = -a_move.speed;
                     robot_moving = MOVE_TURNING;
@@ -54,95 +108,198 @@ void pilot_start_move(move_t a_move) {
                     break;
 
                 default:
-                    printf("Unknown ROTATION parameter\n");
+                    LOG_WARN("Unknown ROTATION parameter %d\n", a_move.parameters[0]);
                     robot_moving = MOVE_DONE;
                     return;
             }
             break;
 
         default:
-            printf("Unknown move direction\n");
+            LOG_WARN("Unknown move direction %d\n", a_move.direction);
             robot_moving = MOVE_DONE;
             return;
     }
 
-    // Set the robot's speed based on the calculated values
-    robot_set_speed(speed_left, speed_right);
+    // Start the speed profile, from the handed over speed and with the encoders at 0
+    robot_reset_wheel_pos();
+    dir_left = (speed_left > 0) - (speed_left < 0);
+    dir_right = (speed_right > 0) - (speed_right < 0);
+    motion_profile_start(&profile, target_pos, abs(a_move.speed), carried_speed);
+    reversing = a_move.direction == ROTATION && carried_speed > 0.0;  // Both wheels still roll forward
+    reversal_pct = -carried_speed;
+    carried_speed = 0.0;
+    speed = (speed_pct_t)lround(motion_profile_step(&profile, 0.0));
+    command_wheels(speed);
 }
 
 // Function to stop the robot when it reaches the target position or detects an obstacle
 move_status_t pilot_stop_at_target(void) {
-    robot_status_t status = robot_get_status();  // Get the current status of the robot
+    robot_snapshot_t snap = robot_get_snapshot();  // Status acquired for this tick
+    // Travel of the wheels in their direction of the move: a wheel still rolling the other way
+    // after a handover counts against the rotation
+    int progress = (dir_left * snap.status.left_encoder + dir_right * snap.status.right_encoder) / 2;
 
+    if (robot_moving == MOVE_DONE || robot_moving == MOVE_FAILED) {
+        return robot_moving;
+    }
+    // Hand over to the next move while still rolling, a little early since
+    // the wheels take some time to follow the new command
+    if (profile.end_pct > 0 && motion_profile_get_config().enabled &&
+        progress >= target_pos - profile.end_pct * SPEED_CTRL_MAX_STEPS_PER_S / 100.0 * motion_profile_get_config().lag_s) {
+        robot_moving = MOVE_DONE;
+        carried_speed = profile.end_pct;
+        target_pos = DEFAULT_TARGET_POS;
+        return robot_moving;
+    }
     // Check if the robot has reached the target position
-    if (status.left_encoder >= target_pos || status.right_encoder >= target_pos) {
-        printf("Stopped\n");
+    if (progress >= target_pos) {
+        LOG_DEBUG("Stopped\n");
         robot_moving = MOVE_DONE;
         robot_reset_wheel_pos();  // Reset the wheel positions
-        robot_set_speed(0, 0);  // Stop the robot
+        speed_ctrl_set_target(0, 0);  // Stop the robot
         target_pos = DEFAULT_TARGET_POS;  // Reset the target position
-    } else if (status.left_sensor < OBSTACLE_DISTANCE_THRESHOLD ||
-               status.center_sensor < OBSTACLE_DISTANCE_THRESHOLD ||
-               status.right_sensor < OBSTACLE_DISTANCE_THRESHOLD) {
-        robot_moving = MOVE_OBSTACLE_FORWARD;  // Change status if an obstacle is detected
+        return robot_moving;
+    }
+    // A forward move waits, wheels stopped, while an obstacle is in the way of what is left of it
+    if (robot_moving == MOVE_FORWARDING || robot_moving == MOVE_OBSTACLE_FORWARD) {
+        obstacle_model_t obstacles = obstacle_model_get();
+        if (!obstacle_model_can_advance(&obstacles, (target_pos - progress) * ODOMETRY_MM_PER_STEP)) {
+            if (robot_moving == MOVE_FORWARDING) {
+                hold_deadline_ns = snap.timestamp_ns + PILOT_HOLD_TIMEOUT_NS;
+            } else if (snap.timestamp_ns >= hold_deadline_ns) {
+                robot_moving = MOVE_FAILED;  // The obstacle stays: give up the move
+                target_pos = DEFAULT_TARGET_POS;
+                speed_ctrl_set_target(0, 0);
+                return robot_moving;
+            }
+            robot_moving = MOVE_OBSTACLE_FORWARD;
+            profile.speed_pct = 0.0;  // Starts again from a standstill
+            profile.accel_pct_s = 0.0;
+            speed_ctrl_set_target(0, 0);
+            return robot_moving;
+        }
+        robot_moving = MOVE_FORWARDING;
     }
+
+    // Speed for this tick, slowing down as the target gets closer
+    speed_pct_t speed = (speed_pct_t)lround(motion_profile_step(&profile, progress));
+    command_wheels(speed);
     return robot_moving;
 }
 
+// Function to set the speed at which the current move hands over to the next one
+void pilot_set_exit_speed(int speed_pct, int next_speed_pct) {
+    motion_profile_config_t config = motion_profile_get_config();
+
+    motion_profile_set_end_speed(&profile, speed_pct);
+    if (robot_moving == MOVE_FORWARDING && profile.end_pct > 0 && config.enabled && config.accel_pct_s > 0) {
+        // While its backward wheel reverses (see command_wheels()), the next rotation still carries
+        // the robot forward by end * cruise / accel: end the forward move that much earlier
+        double drift = profile.end_pct * abs(next_speed_pct) / config.accel_pct_s * SPEED_CTRL_MAX_STEPS_PER_S / 100.0;
+        drift = fmin(drift, target_pos / 2.0);
+        target_pos -= (int)lround(drift);
+        profile.length_steps = target_pos;
+    }
+}
+
 // Function to get the current movement status of the robot
 move_status_t pilot_get_status(void) {
     return robot_moving;
 }
 
+// Starts a wall-following maneuver with the given wheel speeds
+static void start_maneuver(wall_state_t state, speed_pct_t left, speed_pct_t right,
+                           const robot_snapshot_t *snap) {
+    wall_state = state;
+    maneuver_start_pos = snap->status.left_encoder;
+    maneuver_deadline_ns = snap->timestamp_ns + WALL_MANEUVER_TIMEOUT_NS;
+    speed_ctrl_set_target(left, right);
+}
+
+// Checks if the current maneuver has covered its encoder target (or timed out)
+static bool maneuver_done(const robot_snapshot_t *snap, int target) {
+    int travelled = abs(snap->status.left_encoder - maneuver_start_pos);
+    return travelled >= target || snap->timestamp_ns >= maneuver_deadline_ns;
+}
+
+// Function to restart the wall-following state machine
+void pilot_reset_wall_following(void) {
+    wall_state = WALL_DECIDE;
+}
+
 // Function to handle dead angles by forcing a left movement
 void handle_dead_angle(void) {
-    printf("Angle mort détecté ! Forçage d'un déplacement vers la gauche.\n");
-    robot_set_speed(-30, 30);  // Force a left turn
-    usleep(500000);  // Wait for 500 milliseconds
-
-    robot_status_t status = robot_get_status();  // Get the current status of the robot
-    if (status.right_sensor < OBSTACLE_DISTANCE_THRESHOLD) {
-        printf("Mur retrouvé à droite, reprise du suivi.\n");
-        return;  // Resume following the wall if the right sensor detects an obstacle
-    }
+    robot_snapshot_t snap = robot_get_snapshot();
 
-    // If still blocked, perform a forced U-turn
-    printf("Toujours bloqué, demi-tour forcé.\n");
-    robot_set_speed(-30, -30);  // Move backward
-    usleep(500000);  // Wait for 500 milliseconds
-    robot_set_speed(30, -30);  // Turn around
-    usleep(1000000);  // Wait for 1 second
-    robot_set_speed(30, 30);  // Move forward
+    LOG_INFO("Angle mort détecté ! Forçage d'un déplacement vers la gauche.\n");
+    start_maneuver(WALL_DEAD_ANGLE, -WALL_SPEED, WALL_SPEED, &snap);  // Force a left turn
 }
 
-// Function to follow the right wall based on sensor readings
+// Function to follow the right wall based on sensor readings, one tick at a time
 void follow_right_wall(void) {
-    robot_status_t status = robot_get_status();  // Get the current status of the robot
-
-    // Print the sensor readings
-    printf("Capteurs -> Gauche: %d, Devant: %d, Droite: %d\n",
-           status.left_sensor, status.center_sensor, status.right_sensor);
-
-    // Determine if the path is clear based on sensor readings
-    int right_clear = status.right_sensor > OBSTACLE_DISTANCE_THRESHOLD;
-    int front_clear = status.center_sensor > OBSTACLE_DISTANCE_THRESHOLD;
-    int left_clear = status.left_sensor > OBSTACLE_DISTANCE_THRESHOLD;
-
-    // Decide the movement based on the sensor readings
-    if (right_clear) {
-        printf("Tourne à droite\n");
-        robot_set_speed(30, -30);  // Turn right
-        usleep(500000);  // Wait for 500 milliseconds
-        robot_set_speed(30, 30);  // Move forward
-    } else if (front_clear) {
-        printf("Avance tout droit\n");
-        robot_set_speed(30, 30);  // Move forward
-    } else if (left_clear) {
-        printf("Tourne à gauche\n");
-        robot_set_speed(-30, 30);  // Turn left
-        usleep(500000);  // Wait for 500 milliseconds
-        robot_set_speed(30, 30);  // Move forward
-    } else {
-        handle_dead_angle();  // Handle dead angle if all paths are blocked
+    robot_snapshot_t snap = robot_get_snapshot();  // Status acquired for this tick
+    obstacle_model_t obstacles = obstacle_model_get();  // Obstacles seen by the same acquisition
+    const int *sensors = snap.status.sensors;
+
+    switch (wall_state) {
+        case WALL_DECIDE: {
+            // Determine if the path is clear based on sensor readings
+            bool right_clear = obstacle_model_is_free(&obstacles, SENSOR_RIGHT);
+            bool front_clear = obstacle_model_is_free(&obstacles, SENSOR_CENTER);
+            bool left_clear = obstacle_model_is_free(&obstacles, SENSOR_LEFT);
+
+            // Decide the movement based on the sensor readings
+            if (right_clear) {
+                LOG_DEBUG("Capteurs -> Gauche: %d, Devant: %d, Droite: %d. Tourne à droite\n",
+                          sensors[SENSOR_LEFT], sensors[SENSOR_CENTER], sensors[SENSOR_RIGHT]);
+                start_maneuver(WALL_TURN, WALL_SPEED, -WALL_SPEED, &snap);  // Turn right
+            } else if (front_clear) {
+                speed_ctrl_set_target(WALL_SPEED, WALL_SPEED);  // Move forward
+            } else if (left_clear) {
+                LOG_DEBUG("Capteurs -> Gauche: %d, Devant: %d, Droite: %d. Tourne à gauche\n",
+                          sensors[SENSOR_LEFT], sensors[SENSOR_CENTER], sensors[SENSOR_RIGHT]);
+                start_maneuver(WALL_TURN, -WALL_SPEED, WALL_SPEED, &snap);  // Turn left
+            } else {
+                handle_dead_angle();  // Handle dead angle if all paths are blocked
+            }
+            break;
+        }
+
+        case WALL_TURN:
+            if (maneuver_done(&snap, WALL_TURN_TARGET_POS)) {
+                speed_ctrl_set_target(WALL_SPEED, WALL_SPEED);  // Move forward
+                wall_state = WALL_DECIDE;
+            }
+            break;
+
+        case WALL_DEAD_ANGLE:
+            if (maneuver_done(&snap, WALL_TURN_TARGET_POS)) {
+                if (!obstacle_model_is_free(&obstacles, SENSOR_RIGHT)) {
+                    LOG_INFO("Mur retrouvé à droite, reprise du suivi.\n");
+                    wall_state = WALL_DECIDE;  // Resume following the wall
+                } else {
+                    // If still blocked, perform a forced U-turn
+                    LOG_INFO("Toujours bloqué, demi-tour forcé.\n");
+                    start_maneuver(WALL_BACK_UP, -WALL_SPEED, -WALL_SPEED, &snap);  // Move backward
+                }
+            }
+            break;
+
+        case WALL_BACK_UP:
+            if (maneuver_done(&snap, WALL_BACK_UP_TARGET_POS)) {
+                start_maneuver(WALL_U_TURN, WALL_SPEED, -WALL_SPEED, &snap);  // Turn around
+            }
+            break;
+
+        case WALL_U_TURN:
+            if (maneuver_done(&snap, WALL_U_TURN_TARGET_POS)) {
+                speed_ctrl_set_target(WALL_SPEED, WALL_SPEED);  // Move forward
+                wall_state = WALL_DECIDE;
+            }
+            break;
+
+        default:
+            wall_state = WALL_DECIDE;
+            break;
     }
 }
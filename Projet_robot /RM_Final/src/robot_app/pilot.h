@@ -1,6 +1,11 @@
 #ifndef PILOT_H
 #define PILOT_H
 
+/** @brief Encoder steps per unit of FORWARD distance. */
+#define FORWARD_STEPS_PER_DISTANCE 2
+/** @brief Longest wait of a forward move held by an obstacle, on the robot clock (in nanoseconds). */
+#define PILOT_HOLD_TIMEOUT_NS 3000000000ULL
+
 /**
  * @enum move_status_t
  * @brief Enumeration of the movement statuses.
@@ -9,7 +14,8 @@ typedef enum {
     MOVE_FORWARDING,      /**< The robot is moving forward. */
     MOVE_TURNING,         /**< The robot is turning. */
     MOVE_DONE,            /**< The movement is completed. */
-    MOVE_OBSTACLE_FORWARD /**< The robot is moving forward to avoid an obstacle. */
+    MOVE_OBSTACLE_FORWARD, /**< The forward move waits for an obstacle ahead to go away. */
+    MOVE_FAILED           /**< The forward move was held longer than PILOT_HOLD_TIMEOUT_NS, wheels stopped. */
 } move_status_t;
 
 /**
@@ -50,11 +56,33 @@ void pilot_start_move(move_t move);
 
 /**
  * @brief Stops the robot when it reaches the target position.
+ *
+ * A forward move is held, wheels stopped, while the obstacle model sees
+ * an obstacle in the way of what is left of it (MOVE_OBSTACLE_FORWARD),
+ * then goes on. A move still held after PILOT_HOLD_TIMEOUT_NS fails
+ * (MOVE_FAILED) and is not tried again.
  * 
  * @return The current movement status.
  */
 move_status_t pilot_stop_at_target(void);
 
+/**
+ * @brief Lets the current move end at a given speed instead of stopping.
+ *
+ * The move is then reported done slightly before its target, without
+ * stopping the wheels, and the next call to pilot_start_move() starts
+ * from this speed. In a rotation, the wheel that turns backwards is
+ * brought from this forward speed down through 0 under the acceleration
+ * limit of the profiles, so neither wheel jumps. Ignored when the motion
+ * profiles are disabled.
+ *
+ * @param speed_pct The speed at the end of the move (in %, 0 to stop).
+ * @param next_speed_pct The speed of the next move (in %): a forward move
+ *                       ends before its target by the distance the next
+ *                       rotation rolls on while its backward wheel reverses.
+ */
+void pilot_set_exit_speed(int speed_pct, int next_speed_pct);
+
 /**
  * @brief Gets the current movement status of the robot.
  * 
@@ -63,12 +91,23 @@ move_status_t pilot_stop_at_target(void);
 move_status_t pilot_get_status(void);
 
 /**
- * @brief Handles dead angles by forcing a left movement.
+ * @brief Handles dead angles by starting a forced left movement.
+ *
+ * The maneuver is carried on by the next calls to follow_right_wall().
  */
 void handle_dead_angle(void);
 
+/**
+ * @brief Restarts the wall-following state machine from its decision state.
+ */
+void pilot_reset_wall_following(void);
+
 /**
  * @brief Follows the right wall based on sensor readings.
+ *
+ * Runs one step of the wall-following state machine and never waits:
+ * it must be called on every control tick, after the status acquisition.
+ * Turns are tracked with the wheel encoders.
  */
 void follow_right_wall(void);
 
@@ -0,0 +1,464 @@
+#include "planner.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "occupancy_grid.h"
+#include "mrpiz.h"
+#include "../utils.h"
+
+/** @brief Number of cells of the largest grid. */
+#define MAX_CELLS (PLANNER_MAX_SIZE * PLANNER_MAX_SIZE)
+/** @brief Cost of a route that does not exist. */
+#define INF UINT32_MAX
+/** @brief Position in the queue of a cell that is not in it. */
+#define NOT_QUEUED (-1)
+/** @brief Encoder steps for one mm of travel. */
+#define STEPS_PER_MM (1.0 / ODOMETRY_MM_PER_STEP)
+
+/**
+ * An entry of the priority queue: a cell and its key.
+ */
+typedef struct {
+    uint32_t k1;   // Estimated cost of the route through the cell
+    uint32_t k2;   // Cost from the cell to the goal (ties)
+    int32_t cell;  // Index of the cell
+} queue_entry_t;
+
+// Steps of each heading, counterclockwise from +x
+static const int step_x[4] = {1, 0, -1, 0};
+static const int step_y[4] = {0, 1, 0, -1};
+
+static int width, height;                  // Size of the grid
+static uint8_t cost[MAX_CELLS];            // Cost to enter each cell
+static uint32_t g[MAX_CELLS];              // Cost to the goal found so far
+static uint32_t rhs[MAX_CELLS];            // One step lookahead of g
+static queue_entry_t queue[MAX_CELLS];     // Binary heap of the inconsistent cells
+static int32_t queue_pos[MAX_CELLS];       // Position of each cell in the heap
+static int queue_size;                     // Number of cells in the heap
+static int32_t start = -1, goal = -1;      // Cells of the robot and of the goal (-1 if unset)
+static int32_t last_start;                 // Cell of the robot when km was last updated
+static uint32_t km;                        // Key modifier accumulated by the moves of the robot
+static planner_stats_t stats;              // Work done by the searches
+
+static planner_cell_t route[MAX_CELLS];    // Route of planner_plan_path()
+static move_t planned[PLANNER_MAX_MOVES];  // Moves of planner_plan_path()
+static uint8_t wanted[MAX_CELLS];          // Costs read from the occupancy grid
+
+// Adds two costs, INF being absorbing
+static inline uint32_t add_cost(uint32_t a, uint32_t b) {
+    return (a == INF || b == INF) ? INF : a + b;
+}
+
+// Manhattan distance between two cells, a lower bound of the route cost
+static inline uint32_t heuristic(int32_t a, int32_t b) {
+    return (uint32_t)(abs(a % width - b % width) + abs(a / width - b / width));
+}
+
+// Neighbour of a cell in a heading, -1 outside of the grid
+static inline int32_t neighbour(int32_t cell, int heading) {
+    int x = cell % width + step_x[heading];
+    int y = cell / width + step_y[heading];
+    return (x < 0 || y < 0 || x >= width || y >= height) ? -1 : y * width + x;
+}
+
+// Cost of the edge entering a cell
+static inline uint32_t enter_cost(int32_t cell) {
+    return cost[cell] == PLANNER_COST_BLOCKED ? INF : cost[cell];
+}
+
+// Compares two keys
+static inline bool key_less(uint32_t a1, uint32_t a2, uint32_t b1, uint32_t b2) {
+    return a1 < b1 || (a1 == b1 && a2 < b2);
+}
+
+// Computes the key of a cell
+static inline void compute_key(int32_t cell, uint32_t *k1, uint32_t *k2) {
+    uint32_t best = g[cell] < rhs[cell] ? g[cell] : rhs[cell];
+    *k1 = add_cost(add_cost(best, heuristic(start, cell)), km);
+    *k2 = best;
+}
+
+// Swaps two entries of the heap
+static inline void queue_swap(int a, int b) {
+    queue_entry_t entry = queue[a];
+    queue[a] = queue[b];
+    queue[b] = entry;
+    queue_pos[queue[a].cell] = a;
+    queue_pos[queue[b].cell] = b;
+}
+
+// Moves an entry up the heap to its place
+static void sift_up(int i) {
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (!key_less(queue[i].k1, queue[i].k2, queue[parent].k1, queue[parent].k2)) {
+            break;
+        }
+        queue_swap(i, parent);
+        i = parent;
+    }
+}
+
+// Moves an entry down the heap to its place
+static void sift_down(int i) {
+    for (;;) {
+        int child = 2 * i + 1;
+        if (child >= queue_size) {
+            break;
+        }
+        if (child + 1 < queue_size &&
+            key_less(queue[child + 1].k1, queue[child + 1].k2, queue[child].k1, queue[child].k2)) {
+            child++;
+        }
+        if (!key_less(queue[child].k1, queue[child].k2, queue[i].k1, queue[i].k2)) {
+            break;
+        }
+        queue_swap(i, child);
+        i = child;
+    }
+}
+
+// Inserts a cell in the queue, or changes its key
+static void queue_set(int32_t cell, uint32_t k1, uint32_t k2) {
+    int i = queue_pos[cell];
+
+    if (i == NOT_QUEUED) {
+        i = queue_size++;
+        queue[i].cell = cell;
+        queue_pos[cell] = i;
+    }
+    queue[i].k1 = k1;
+    queue[i].k2 = k2;
+    sift_up(i);
+    sift_down(queue_pos[cell]);
+}
+
+// Removes a cell from the queue
+static void queue_remove(int32_t cell) {
+    int i = queue_pos[cell];
+
+    queue_size--;
+    if (i != queue_size) {
+        int32_t moved = queue[queue_size].cell;
+        queue_swap(i, queue_size);
+        sift_up(i);
+        sift_down(queue_pos[moved]);
+    }
+    queue_pos[cell] = NOT_QUEUED;
+}
+
+// Best cost to the goal through the neighbours of a cell
+static uint32_t best_neighbour_cost(int32_t cell) {
+    uint32_t best = INF;
+
+    for (int h = 0; h < 4; h++) {
+        int32_t n = neighbour(cell, h);
+        if (n >= 0) {
+            uint32_t c = add_cost(enter_cost(n), g[n]);
+            best = c < best ? c : best;
+        }
+    }
+    return best;
+}
+
+// Queues a cell if it is inconsistent, removes it otherwise
+static void update_vertex(int32_t cell) {
+    if (g[cell] != rhs[cell]) {
+        uint32_t k1, k2;
+        compute_key(cell, &k1, &k2);
+        queue_set(cell, k1, k2);
+    } else if (queue_pos[cell] != NOT_QUEUED) {
+        queue_remove(cell);
+    }
+}
+
+// Expands the cells until the route of the start is known
+static void compute_shortest_path(void) {
+    uint32_t start_k1, start_k2;
+
+    compute_key(start, &start_k1, &start_k2);
+    while (queue_size > 0 &&
+           (key_less(queue[0].k1, queue[0].k2, start_k1, start_k2) || rhs[start] != g[start])) {
+        int32_t u = queue[0].cell;
+        uint32_t old_k1 = queue[0].k1, old_k2 = queue[0].k2, k1, k2;
+
+        stats.last_expansions++;
+        compute_key(u, &k1, &k2);
+        if (key_less(old_k1, old_k2, k1, k2)) {
+            queue_set(u, k1, k2);  // Key outdated by the moves of the robot
+        } else if (g[u] > rhs[u]) {
+            // Cheaper than known: propagate to the cells entering it
+            g[u] = rhs[u];
+            queue_remove(u);
+            for (int h = 0; h < 4; h++) {
+                int32_t s = neighbour(u, h);
+                if (s >= 0 && s != goal) {
+                    uint32_t c = add_cost(enter_cost(u), g[u]);
+                    rhs[s] = c < rhs[s] ? c : rhs[s];
+                    update_vertex(s);
+                }
+            }
+        } else {
+            // More expensive than known: the cells that went through it look again
+            uint32_t old_g = g[u];
+            g[u] = INF;
+            for (int h = 0; h < 4; h++) {
+                int32_t s = neighbour(u, h);
+                if (s >= 0 && s != goal && rhs[s] == add_cost(enter_cost(u), old_g)) {
+                    rhs[s] = best_neighbour_cost(s);
+                    update_vertex(s);
+                }
+            }
+            if (u != goal) {
+                rhs[u] = best_neighbour_cost(u);
+            }
+            update_vertex(u);
+        }
+        compute_key(start, &start_k1, &start_k2);
+    }
+}
+
+// Sizes the grid with all the cells free
+int planner_init(int new_width, int new_height) {
+    if (new_width <= 0 || new_height <= 0 || new_width > PLANNER_MAX_SIZE || new_height > PLANNER_MAX_SIZE) {
+        return -1;
+    }
+    width = new_width;
+    height = new_height;
+    memset(cost, PLANNER_COST_FREE, sizeof(cost));
+    start = goal = -1;
+    queue_size = 0;
+    stats = (planner_stats_t){0, 0, 0, 0};
+    return 0;
+}
+
+// Sets the cost to enter a cell, repairing the current search
+void planner_set_cost(planner_cell_t cell, uint8_t new_cost) {
+    if (cell.x < 0 || cell.y < 0 || cell.x >= width || cell.y >= height) {
+        return;
+    }
+    int32_t v = cell.y * width + cell.x;
+    if (new_cost == cost[v]) {
+        return;
+    }
+    cost[v] = new_cost;
+    if (goal < 0) {
+        return;
+    }
+    // Only the edges entering the cell changed: its neighbours look again
+    for (int h = 0; h < 4; h++) {
+        int32_t s = neighbour(v, h);
+        if (s >= 0 && s != goal) {
+            rhs[s] = best_neighbour_cost(s);
+            update_vertex(s);
+        }
+    }
+}
+
+// Gets the cost to enter a cell
+uint8_t planner_get_cost(planner_cell_t cell) {
+    if (cell.x < 0 || cell.y < 0 || cell.x >= width || cell.y >= height) {
+        return PLANNER_COST_BLOCKED;
+    }
+    return cost[cell.y * width + cell.x];
+}
+
+// Sets the goal and starts a new search
+void planner_set_goal(planner_cell_t cell) {
+    size_t cells = (size_t)width * (size_t)height;
+    uint32_t k1, k2;
+
+    if (cell.x < 0 || cell.y < 0 || cell.x >= width || cell.y >= height) {
+        goal = -1;
+        return;
+    }
+    memset(g, 0xFF, cells * sizeof(g[0]));  // INF
+    memset(rhs, 0xFF, cells * sizeof(rhs[0]));
+    memset(queue_pos, 0xFF, cells * sizeof(queue_pos[0]));  // NOT_QUEUED
+    queue_size = 0;
+    km = 0;
+    goal = cell.y * width + cell.x;
+    if (start < 0) {
+        start = goal;
+    }
+    last_start = start;
+    rhs[goal] = 0;
+    compute_key(goal, &k1, &k2);
+    queue_set(goal, k1, k2);
+}
+
+// Sets the cell of the robot, keeping the current search
+void planner_set_start(planner_cell_t cell) {
+    if (cell.x < 0 || cell.y < 0 || cell.x >= width || cell.y >= height) {
+        return;
+    }
+    start = cell.y * width + cell.x;
+    if (goal >= 0) {
+        // The keys already queued lower-bound the new ones once raised by the distance moved
+        km += heuristic(last_start, start);
+        last_start = start;
+    }
+}
+
+// Completes the search after the changes of cost, goal or start
+int planner_compute(void) {
+    uint64_t begin = monotonic_ns();
+
+    if (goal < 0 || start < 0) {
+        return -1;
+    }
+    stats.last_expansions = 0;
+    compute_shortest_path();
+    stats.searches++;
+    stats.expansions += stats.last_expansions;
+    stats.last_search_ns = monotonic_ns() - begin;
+    return g[start] == INF ? -1 : (int)g[start];
+}
+
+// Gets the route found by the last search, going straight on when costs are equal
+int planner_get_route(planner_cell_t *cells, int max) {
+    int32_t cell = start;
+    int heading = -1;
+    int count = 0;
+
+    if (goal < 0 || start < 0 || g[start] == INF) {
+        return -1;
+    }
+    for (;;) {
+        if (count == max) {
+            return -1;
+        }
+        cells[count++] = (planner_cell_t){cell % width, cell / width};
+        if (cell == goal) {
+            return count;
+        }
+        uint32_t best = INF;
+        int best_heading = -1;
+        for (int i = 0; i < 4; i++) {
+            int h = heading < 0 ? i : (heading + i) % 4;  // Current heading first
+            int32_t n = neighbour(cell, h);
+            if (n >= 0) {
+                uint32_t c = add_cost(enter_cost(n), g[n]);
+                if (c < best) {
+                    best = c;
+                    best_heading = h;
+                }
+            }
+        }
+        if (best == INF) {
+            return -1;  // The search was not completed
+        }
+        heading = best_heading;
+        cell = neighbour(cell, heading);
+    }
+}
+
+// Adds a move to a path
+static bool add_move(move_t *moves, int *count, int max, move_t move) {
+    if (*count == max) {
+        return false;
+    }
+    moves[(*count)++] = move;
+    return true;
+}
+
+// Turns a route into moves of the pilot
+int planner_route_to_moves(const planner_cell_t *cells, int count, planner_heading_t heading,
+                           double cell_mm, move_t *moves, int max) {
+    double distance_per_cell = cell_mm * STEPS_PER_MM / FORWARD_STEPS_PER_DISTANCE;
+    int current = (int)heading;
+    int run = 0;
+    int steps = 0;
+
+    for (int i = 1; i < count; i++) {
+        int dx = cells[i].x - cells[i - 1].x, dy = cells[i].y - cells[i - 1].y;
+        int h = 0;
+        while (h < 3 && (step_x[h] != dx || step_y[h] != dy)) {
+            h++;
+        }
+        if (h != current) {
+            if (run > 0 && !add_move(moves, &steps, max,
+                                     (move_t){FORWARD, {(int)lround(run * distance_per_cell), 0}, PATH_FULL_SPEED})) {
+                return -1;
+            }
+            int turn = (h - current + 4) % 4;  // Quarter turns counterclockwise
+            int rotation = turn == 1 ? LEFT : (turn == 3 ? RIGHT : U_TURN);
+            if (!add_move(moves, &steps, max, (move_t){ROTATION, {rotation, 0}, PATH_FULL_SPEED})) {
+                return -1;
+            }
+            current = h;
+            run = 0;
+        }
+        run++;
+    }
+    if (run > 0 && !add_move(moves, &steps, max,
+                             (move_t){FORWARD, {(int)lround(run * distance_per_cell), 0}, PATH_FULL_SPEED})) {
+        return -1;
+    }
+    return steps;
+}
+
+// Gives to the search the cells whose cost changed in the occupancy grid
+static void update_costs_from_map(void) {
+    int clearance = (PLANNER_CLEARANCE_MM + OCC_GRID_CELL_MM - 1) / OCC_GRID_CELL_MM;
+
+    memset(wanted, PLANNER_COST_FREE, (size_t)width * (size_t)height);
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            if (occupancy_grid_cell_state(x, y) != CELL_OCCUPIED) {
+                continue;
+            }
+            for (int ny = y - clearance; ny <= y + clearance; ny++) {
+                for (int nx = x - clearance; nx <= x + clearance; nx++) {
+                    if (nx >= 0 && ny >= 0 && nx < width && ny < height &&
+                        (nx - x) * (nx - x) + (ny - y) * (ny - y) <= clearance * clearance &&
+                        wanted[ny * width + nx] != PLANNER_COST_BLOCKED) {
+                        wanted[ny * width + nx] = PLANNER_COST_NEAR;
+                    }
+                }
+            }
+            wanted[y * width + x] = PLANNER_COST_BLOCKED;
+        }
+    }
+    for (int32_t i = 0; i < width * height; i++) {
+        if (wanted[i] != cost[i]) {
+            planner_set_cost((planner_cell_t){i % width, i / width}, wanted[i]);
+        }
+    }
+}
+
+// Plans a path from the estimated pose to a goal, on the occupancy grid
+int planner_plan_path(const odometry_pose_t *pose, double goal_x_mm, double goal_y_mm, path_t *path) {
+    planner_cell_t from, to;
+    int heading = (int)lround(pose->theta_rad / (M_PI / 2.0));
+
+    if (width != OCC_GRID_SIZE || height != OCC_GRID_SIZE) {
+        planner_init(OCC_GRID_SIZE, OCC_GRID_SIZE);
+    }
+    if (!occupancy_grid_to_cell(pose->x_mm, pose->y_mm, &from.x, &from.y) ||
+        !occupancy_grid_to_cell(goal_x_mm, goal_y_mm, &to.x, &to.y)) {
+        return -1;
+    }
+    update_costs_from_map();
+    planner_set_start(from);
+    if (goal != to.y * width + to.x) {
+        planner_set_goal(to);  // Same goal: the previous search is repaired
+    }
+    if (planner_compute() < 0) {
+        return -1;
+    }
+    int count = planner_get_route(route, MAX_CELLS);
+    int steps = count < 0 ? -1 :
+                planner_route_to_moves(route, count, (planner_heading_t)((heading % 4 + 4) % 4),
+                                       OCC_GRID_CELL_MM, planned, PLANNER_MAX_MOVES);
+    if (steps < 0) {
+        return -1;
+    }
+    *path = (path_t){"planned", planned, steps};
+    return 0;
+}
+
+// Gets the work done by the searches
+planner_stats_t planner_get_stats(void) {
+    return stats;
+}
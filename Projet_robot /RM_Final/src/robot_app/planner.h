@@ -0,0 +1,161 @@
+#ifndef PLANNER_H
+#define PLANNER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "pilot.h"
+#include "path_registry.h"
+#include "odometry.h"
+
+/**
+ * @file planner.h
+ * @brief Incremental path planner (D* Lite) on a grid, giving copilot paths.
+ *
+ * The planner searches from the goal towards the robot on a 4-connected
+ * grid where each cell has a cost to enter. When cell costs change, only
+ * the part of the search they affect is repaired, and when the robot
+ * moves the search is kept (D* Lite, Koenig and Likhachev 2002): a new
+ * route costs a fraction of a search from scratch.
+ *
+ * The route is turned into moves of the pilot: a FORWARD move per straight
+ * run of cells, a quarter turn (LEFT or RIGHT) or a U_TURN between them.
+ * All the memory is static: no allocation while planning.
+ */
+
+/** @brief Largest side of the planning grid (in cells). */
+#define PLANNER_MAX_SIZE 256
+/** @brief Cost of a cell that cannot be entered. */
+#define PLANNER_COST_BLOCKED 255
+/** @brief Cost of a free cell. */
+#define PLANNER_COST_FREE 1
+/** @brief Cost of a cell closer to an obstacle than the robot radius. */
+#define PLANNER_COST_NEAR 20
+/** @brief Distance to an obstacle under which a cell costs PLANNER_COST_NEAR (in mm). */
+#define PLANNER_CLEARANCE_MM 40
+/** @brief Largest number of moves of a planned path. */
+#define PLANNER_MAX_MOVES 256
+
+/**
+ * @struct planner_cell_t
+ * @brief A cell of the planning grid.
+ */
+typedef struct {
+    int x;  /**< Column */
+    int y;  /**< Row */
+} planner_cell_t;
+
+/**
+ * @enum planner_heading_t
+ * @brief Directions along the grid, counterclockwise.
+ */
+typedef enum {
+    HEADING_EAST,   /**< Towards +x */
+    HEADING_NORTH,  /**< Towards +y (left of HEADING_EAST) */
+    HEADING_WEST,   /**< Towards -x */
+    HEADING_SOUTH   /**< Towards -y */
+} planner_heading_t;
+
+/**
+ * @struct planner_stats_t
+ * @brief Work done by the searches.
+ */
+typedef struct {
+    uint64_t searches;        /**< Number of calls to planner_compute() */
+    uint64_t expansions;      /**< Cells expanded by all the searches */
+    uint32_t last_expansions; /**< Cells expanded by the last search */
+    uint64_t last_search_ns;  /**< Duration of the last search (in nanoseconds) */
+} planner_stats_t;
+
+/**
+ * @brief Sizes the grid, with all the cells free, and forgets the goal.
+ *
+ * @param width The number of columns.
+ * @param height The number of rows.
+ * @return 0 on success, -1 if the grid is larger than PLANNER_MAX_SIZE.
+ */
+int planner_init(int width, int height);
+
+/**
+ * @brief Sets the cost to enter a cell, repairing the current search.
+ *
+ * @param cell The cell.
+ * @param cost The cost (PLANNER_COST_FREE to PLANNER_COST_BLOCKED).
+ */
+void planner_set_cost(planner_cell_t cell, uint8_t cost);
+
+/**
+ * @brief Gets the cost to enter a cell.
+ *
+ * @param cell The cell.
+ * @return The cost, PLANNER_COST_BLOCKED outside of the grid.
+ */
+uint8_t planner_get_cost(planner_cell_t cell);
+
+/**
+ * @brief Sets the goal and starts a new search.
+ *
+ * @param goal The goal cell.
+ */
+void planner_set_goal(planner_cell_t goal);
+
+/**
+ * @brief Sets the cell of the robot, keeping the current search.
+ *
+ * @param start The cell of the robot.
+ */
+void planner_set_start(planner_cell_t start);
+
+/**
+ * @brief Completes the search after the changes of cost, goal or start.
+ *
+ * @return The cost of the route from the start to the goal, -1 if there is none.
+ */
+int planner_compute(void);
+
+/**
+ * @brief Gets the route found by the last planner_compute().
+ *
+ * @param route Where to store the cells, start and goal included.
+ * @param max The size of route.
+ * @return The number of cells of the route, -1 if there is none or it is longer than max.
+ */
+int planner_get_route(planner_cell_t *route, int max);
+
+/**
+ * @brief Turns a route into moves of the pilot.
+ *
+ * @param route The cells of the route.
+ * @param count The number of cells.
+ * @param heading The heading of the robot at the start.
+ * @param cell_mm The side of a cell (in mm).
+ * @param moves Where to store the moves (speeds at PATH_FULL_SPEED).
+ * @param max The size of moves.
+ * @return The number of moves, -1 if there are more than max.
+ */
+int planner_route_to_moves(const planner_cell_t *route, int count, planner_heading_t heading,
+                           double cell_mm, move_t *moves, int max);
+
+/**
+ * @brief Plans a path from the estimated pose to a goal, on the occupancy grid.
+ *
+ * The costs are taken from the occupancy grid: occupied cells are blocked,
+ * cells closer than PLANNER_CLEARANCE_MM to them are expensive, unknown
+ * cells are assumed free. Only the cells that changed since the previous
+ * call are given to the search, which is kept while the goal is the same.
+ *
+ * @param pose The pose of the robot (its heading is rounded to the grid).
+ * @param goal_x_mm The x position of the goal (in mm).
+ * @param goal_y_mm The y position of the goal (in mm).
+ * @param path Where to store the path, valid until the next call.
+ * @return 0 on success, -1 if the goal cannot be reached.
+ */
+int planner_plan_path(const odometry_pose_t *pose, double goal_x_mm, double goal_y_mm, path_t *path);
+
+/**
+ * @brief Gets the work done by the searches since planner_init().
+ *
+ * @return A copy of the statistics.
+ */
+planner_stats_t planner_get_stats(void);
+
+#endif // PLANNER_H
@@ -2,79 +2,377 @@
 
 #include "robot.h"
 #include "mrpiz.h"
+#include "mrpiz_trace.h"
+#include "link_stats.h"
+#include "obstacle_model.h"
+#include "sensor_filter.h"
+#include "clock.h"
 #include <errno.h>
+#include <pthread.h>
+#include <stdbool.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include "../utils.h"
+
+static robot_snapshot_t snapshot;              // Last status acquired on the link
+static robot_snapshot_stats_t snapshot_stats;  // Snapshot usage counters
+static pthread_mutex_t snapshot_lock = PTHREAD_MUTEX_INITIALIZER; // Shared by control and UI threads
+static speed_pct_t commanded_left;   // Last speed sent to the left wheel
+static speed_pct_t commanded_right;  // Last speed sent to the right wheel
+
+/*
+ * Actuator cache: the link only sees the commands that change something.
+ * The speeds asked for are kept pending while a tick holds the commands,
+ * and compared with the last ones sent, which are trusted until a send
+ * fails or the link is restarted.
+ */
+static pthread_mutex_t command_lock = PTHREAD_MUTEX_INITIALIZER; // Shared by control and UI threads
+static speed_pct_t pending_left;     // Last speed asked for the left wheel
+static speed_pct_t pending_right;    // Last speed asked for the right wheel
+static bool pending_fresh;           // true if a speed was asked for since the last flush
+static bool left_known;              // true if commanded_left is the speed of the left wheel
+static bool right_known;             // true if commanded_right is the speed of the right wheel
+static bool holding;                 // true between robot_hold_commands() and robot_flush_commands()
+static int led_color = -1;           // Last color set on the LED (-1 if unknown)
+static robot_command_stats_t command_stats;  // Actuator command counters
+
+/*
+ * Link wrappers: every mrpiz call of the application goes through them,
+ * so that it can be timed (see link_stats.h) and recorded in the trace
+ * (see mrpiz_trace.h).
+ */
+
+// Marks the start of a link call (0 if nothing observes the call)
+static inline uint64_t link_begin(void) {
+  return (link_stats_enabled() || mrpiz_trace_enabled()) ? monotonic_ns() : 0;
+}
+
+// Marks the end of a link call, then times and records it if needed
+static inline void link_end(mrpiz_call_t call, int arg0, int arg1, int ret, uint64_t start) {
+  if (start != 0) {
+    uint64_t end = monotonic_ns();
+    if (link_stats_enabled()) {
+      link_stats_record(call, end - start);
+    }
+    if (mrpiz_trace_enabled()) {
+      mrpiz_trace_log(call, arg0, arg1, ret, start, end);
+    }
+  }
+}
+
+static int link_init(void) {
+  const char *address = getenv(ROBOT_ADDRESS_ENV);
+  const char *port = getenv(ROBOT_PORT_ENV);
+  uint64_t start = link_begin();
+  // Chosen at run time, so that one binary can drive any simulator
+  int ret = mrpiz_init_intox(address != NULL ? address : ROBOT_DEFAULT_ADDRESS,
+                             port != NULL ? atoi(port) : ROBOT_DEFAULT_PORT);
+  link_end(MRPIZ_CALL_INIT, 0, 0, ret, start);
+  return ret;
+}
+
+static void link_close(void) {
+  uint64_t start = link_begin();
+  mrpiz_close();
+  link_end(MRPIZ_CALL_CLOSE, 0, 0, 0, start);
+}
+
+static int link_motor_set(mrpiz_motor_id id, int cmd) {
+  uint64_t start = link_begin();
+  int ret = mrpiz_motor_set(id, cmd);
+  link_end(MRPIZ_CALL_MOTOR_SET, id, cmd, ret, start);
+  return ret;
+}
+
+static int link_encoder_get(mrpiz_motor_id id) {
+  uint64_t start = link_begin();
+  int ret = mrpiz_motor_encoder_get(id);
+  link_end(MRPIZ_CALL_ENCODER_GET, id, 0, ret, start);
+  return ret;
+}
+
+static int link_encoder_reset(mrpiz_motor_id id) {
+  uint64_t start = link_begin();
+  int ret = mrpiz_motor_encoder_reset(id);
+  link_end(MRPIZ_CALL_ENCODER_RESET, id, 0, ret, start);
+  return ret;
+}
+
+static int link_proxy_sensor_get(mrpiz_proxy_sensor_id id) {
+  uint64_t start = link_begin();
+  int ret = mrpiz_proxy_sensor_get(id);
+  link_end(MRPIZ_CALL_PROXY_SENSOR_GET, id, 0, ret, start);
+  return ret;
+}
+
+static int link_battery_level(void) {
+  uint64_t start = link_begin();
+  int ret = mrpiz_battery_level();
+  link_end(MRPIZ_CALL_BATTERY_LEVEL, 0, 0, ret, start);
+  return ret;
+}
+
+static int link_led_rgb_set(mrpiz_led_rgb_color_t color) {
+  uint64_t start = link_begin();
+  int ret = mrpiz_led_rgb_set(color);
+  link_end(MRPIZ_CALL_LED_RGB_SET, color, 0, ret, start);
+  return ret;
+}
 
 // Initializes the robot
 int robot_start(void) {
   int result = 0;
+  const char *trace_path = getenv(MRPIZ_TRACE_ENV);
+
+  // Record every link call if asked to
+  if (trace_path != NULL && mrpiz_trace_open(trace_path) == 0) {
+      printf("Enregistrement des appels mrpiz dans %s\n", trace_path);
+  }
 
   // Initialize the mrpiz library and check for errors
-  if (mrpiz_init() != 0) {
+  if (link_init() != 0) {
       mrpiz_error_print("Problème d'initialisation"); // Display initialization error
   }
 
+  // Nothing is known of the actuators of a new link
+  pthread_mutex_lock(&command_lock);
+  left_known = right_known = false;
+  led_color = -1;
+  pthread_mutex_unlock(&command_lock);
+
   return result;
 }
 
+// Sends a wheel speed and remembers it if the link accepted it
+static void send_speed(mrpiz_motor_id id, speed_pct_t speed) {
+    bool sent = link_motor_set(id, speed) == 0;
+
+    command_stats.motor_calls++;
+    if (id != MRPIZ_MOTOR_RIGHT) {
+        __atomic_store_n(&commanded_left, speed, __ATOMIC_RELAXED);
+        left_known = sent;
+    }
+    if (id != MRPIZ_MOTOR_LEFT) {
+        __atomic_store_n(&commanded_right, speed, __ATOMIC_RELAXED);
+        right_known = sent;
+    }
+}
+
+// Sends the pending speeds of the wheels that changed (command_lock held)
+static void flush_speeds(void) {
+    bool left = !left_known || pending_left != commanded_left;
+    bool right = !right_known || pending_right != commanded_right;
+
+    if (left && right && pending_left == pending_right) {
+        send_speed(MRPIZ_MOTOR_BOTH, pending_left);  // One call for both wheels
+    } else {
+        if (left) {
+            send_speed(MRPIZ_MOTOR_LEFT, pending_left);
+        }
+        if (right) {
+            send_speed(MRPIZ_MOTOR_RIGHT, pending_right);
+        }
+    }
+    pending_fresh = false;
+}
+
 // Sets the speed of the left and right wheels
 void robot_set_speed(speed_pct_t left, speed_pct_t right) {
-  mrpiz_motor_set(MRPIZ_MOTOR_LEFT, left); // Set left wheel speed
-  mrpiz_motor_set(MRPIZ_MOTOR_RIGHT, right); // Set right wheel speed
+  pthread_mutex_lock(&command_lock);
+  command_stats.speed_requests++;
+  if (pending_fresh) {
+      command_stats.coalesced++;  // The previous request of the tick is not sent
+  }
+  pending_left = left;
+  pending_right = right;
+  pending_fresh = true;
+  if (!holding) {
+      flush_speeds();  // Write-through outside of a tick
+  } else if (left == 0 && right == 0) {
+      command_stats.immediate_stops++;
+      flush_speeds();  // A stop never waits for the end of the tick
+  }
+  pthread_mutex_unlock(&command_lock);
+}
+
+// Holds the speed commands until the next flush
+void robot_hold_commands(void) {
+    pthread_mutex_lock(&command_lock);
+    holding = true;
+    pthread_mutex_unlock(&command_lock);
+}
+
+// Sends the speeds held since robot_hold_commands() if they changed
+void robot_flush_commands(void) {
+    pthread_mutex_lock(&command_lock);
+    holding = false;
+    if (pending_fresh || !left_known || !right_known) {
+        flush_speeds();
+    }
+    pthread_mutex_unlock(&command_lock);
+}
+
+// Retrieves the actuator command counters
+robot_command_stats_t robot_get_command_stats(void) {
+    robot_command_stats_t copy;
+
+    pthread_mutex_lock(&command_lock);
+    copy = command_stats;
+    pthread_mutex_unlock(&command_lock);
+    unsigned long requested = 2 * copy.speed_requests;  // Without the cache, every request set both wheels
+    copy.motor_calls_saved = requested > copy.motor_calls ? requested - copy.motor_calls : 0;
+    return copy;
+}
+
+// Resets the actuator command counters
+void robot_reset_command_stats(void) {
+    pthread_mutex_lock(&command_lock);
+    command_stats = (robot_command_stats_t){0};
+    pthread_mutex_unlock(&command_lock);
+}
+
+// Retrieves the last speeds sent to the wheels
+void robot_get_commanded_speed(speed_pct_t *left, speed_pct_t *right) {
+  *left = __atomic_load_n(&commanded_left, __ATOMIC_RELAXED);
+  *right = __atomic_load_n(&commanded_right, __ATOMIC_RELAXED);
 }
 
 // Retrieves the encoder position of a given wheel
 int robot_get_wheel_position(wheel_t wheel_id) {
-   return mrpiz_motor_encoder_get(wheel_id);
+   return link_encoder_get((mrpiz_motor_id)wheel_id);
 }
 
 // Resets the encoder positions for both wheels
 void robot_reset_wheel_pos(void) {
-  mrpiz_motor_encoder_reset(MRPIZ_MOTOR_BOTH);
+  link_encoder_reset(MRPIZ_MOTOR_BOTH);
+  // Keep the snapshot coherent with the link until the next acquisition
+  pthread_mutex_lock(&snapshot_lock);
+  snapshot.status.left_encoder = 0;
+  snapshot.status.right_encoder = 0;
+  snapshot.encoder_resets++;
+  pthread_mutex_unlock(&snapshot_lock);
 }
 
-// Retrieves the current status of the robot
-robot_status_t robot_get_status(void) {
+// Acquires the current status of the robot in one sweep of the link
+void robot_refresh_status(void) {
     robot_status_t status;
 
-    // Get sensor readings
-    status.left_sensor = mrpiz_proxy_sensor_get(MRPIZ_PROXY_SENSOR_FRONT_LEFT);
-    status.right_sensor = mrpiz_proxy_sensor_get(MRPIZ_PROXY_SENSOR_FRONT_RIGHT);
-    status.center_sensor = mrpiz_proxy_sensor_get(MRPIZ_PROXY_SENSOR_FRONT_CENTER);
-    
+    // Get sensor readings, from left to right (mrpiz numbers them from 1 in the same order)
+    for (int i = 0; i < SENSOR_NB; i++) {
+        status.sensors[i] = link_proxy_sensor_get((mrpiz_proxy_sensor_id)(MRPIZ_PROXY_SENSOR_FRONT_LEFT + i));
+    }
+
     // Get encoder positions
-    status.left_encoder = mrpiz_motor_encoder_get(MRPIZ_MOTOR_LEFT);
-    status.right_encoder = mrpiz_motor_encoder_get(MRPIZ_MOTOR_RIGHT);
+    status.left_encoder = link_encoder_get(MRPIZ_MOTOR_LEFT);
+    status.right_encoder = link_encoder_get(MRPIZ_MOTOR_RIGHT);
     
     // Get battery level
-    status.battery = mrpiz_battery_level();
-    
-    return status;
+    status.battery = link_battery_level();
+
+    uint64_t timestamp = clock_now_ns();
+    uint32_t seq;
+
+    pthread_mutex_lock(&snapshot_lock);
+    snapshot.status = status;
+    snapshot.timestamp_ns = timestamp;
+    seq = ++snapshot.seq;
+    snapshot_stats.acquisitions++;
+    snapshot_stats.link_calls += ROBOT_STATUS_LINK_CALLS;
+    pthread_mutex_unlock(&snapshot_lock);
+
+    // Filtered and fused once per acquisition, so every consumer sees the
+    // same obstacles; the snapshot keeps the raw readings
+    robot_status_t filtered = status;
+    sensor_filter_update(status.sensors, filtered.sensors);
+    obstacle_model_update(&filtered, seq);
+}
+
+// Copies the last snapshot, acquiring it first if none exists yet; count_read is set for the
+// status reads that went to the link before the snapshot, the only ones it saves calls for
+static robot_snapshot_t read_snapshot(bool count_read) {
+    robot_snapshot_t copy;
+    bool acquired = false;
+
+    pthread_mutex_lock(&snapshot_lock);
+    if (snapshot.seq == 0) {
+        pthread_mutex_unlock(&snapshot_lock);
+        robot_refresh_status();  // No acquisition yet
+        pthread_mutex_lock(&snapshot_lock);
+        acquired = true;
+    }
+    if (count_read) {
+        snapshot_stats.reads++;
+        if (!acquired) {
+            snapshot_stats.link_calls_avoided += ROBOT_STATUS_LINK_CALLS;
+        }
+    }
+    copy = snapshot;
+    pthread_mutex_unlock(&snapshot_lock);
+    return copy;
+}
+
+// Retrieves the current status of the robot from the last snapshot
+robot_status_t robot_get_status(void) {
+    return read_snapshot(true).status;
+}
+
+// Retrieves the last snapshot with its timestamp and sequence number
+robot_snapshot_t robot_get_snapshot(void) {
+    return read_snapshot(false);
+}
+
+// Retrieves the snapshot usage counters
+robot_snapshot_stats_t robot_get_snapshot_stats(void) {
+    robot_snapshot_stats_t copy;
+
+    pthread_mutex_lock(&snapshot_lock);
+    copy = snapshot_stats;
+    pthread_mutex_unlock(&snapshot_lock);
+    return copy;
+}
+
+// Resets the snapshot usage counters
+void robot_reset_snapshot_stats(void) {
+    pthread_mutex_lock(&snapshot_lock);
+    snapshot_stats = (robot_snapshot_stats_t){0};
+    pthread_mutex_unlock(&snapshot_lock);
 }
 
 // Controls the LED signal based on the robot's status
 void robot_signal_event(notification_t event) {
+  mrpiz_led_rgb_color_t color;
+
   switch (event) {
   case ROBOT_OK:
-    mrpiz_led_rgb_set(MRPIZ_LED_OFF); // Turn off LED for normal status
+    color = MRPIZ_LED_OFF; // Turn off LED for normal status
     break;
   case ROBOT_OBSTACLE:
-    mrpiz_led_rgb_set(MRPIZ_LED_RED); // Red LED indicates an obstacle detected
+    color = MRPIZ_LED_RED; // Red LED indicates an obstacle detected
     break;
   case ROBOT_PROBLEM:
-    mrpiz_led_rgb_set(MRPIZ_LED_GREEN); // Green LED signals a problem
+    color = MRPIZ_LED_GREEN; // Green LED signals a problem
     break;
   case ROBOT_IDLE:
-    mrpiz_led_rgb_set(MRPIZ_LED_BLUE); // Blue LED indicates idle mode
+    color = MRPIZ_LED_BLUE; // Blue LED indicates idle mode
     break;
   default:
-    mrpiz_led_rgb_set(MRPIZ_LED_OFF); // Default case turns LED off
+    color = MRPIZ_LED_OFF; // Default case turns LED off
     break;
   }
+
+  pthread_mutex_lock(&command_lock);
+  command_stats.led_requests++;
+  if (led_color == (int)color) {
+    command_stats.led_calls_saved++;  // Already showing this color
+  } else {
+    led_color = link_led_rgb_set(color) == 0 ? (int)color : -1;
+  }
+  pthread_mutex_unlock(&command_lock);
 }
 
 // Stops the robot and closes the mrpiz library
 void robot_close(void) {
   robot_set_speed(0, 0); // Stop the robot
-  mrpiz_close(); // Close the mrpiz library
+  link_close(); // Close the mrpiz library
+  mrpiz_trace_close();
 }
@@ -1,11 +1,36 @@
 #ifndef ROBOT_H
 #define ROBOT_H
 
+#include <stdint.h>
+
 /**
  * @file robot.h
  * @brief Declaration of the Robot class.
  */
 
+/** @brief Number of link calls needed for one full status acquisition. */
+#define ROBOT_STATUS_LINK_CALLS 8
+
+/** @brief Environment variable giving the address of the simulator (ROBOT_DEFAULT_ADDRESS if unset). */
+#define ROBOT_ADDRESS_ENV "MRPIZ_ADDRESS"
+/** @brief Environment variable giving the port of the simulator (ROBOT_DEFAULT_PORT if unset). */
+#define ROBOT_PORT_ENV "MRPIZ_PORT"
+
+#define ROBOT_STR_(s) #s
+#define ROBOT_STR(s) ROBOT_STR_(s)
+#ifdef INTOX_ADDRESS
+/** @brief Address of the simulator, set at compile time by the Makefile. */
+#define ROBOT_DEFAULT_ADDRESS ROBOT_STR(INTOX_ADDRESS)
+#else
+#define ROBOT_DEFAULT_ADDRESS "127.0.0.1"
+#endif
+#ifdef INTOX_PORT
+/** @brief Port of the simulator, set at compile time by the Makefile. */
+#define ROBOT_DEFAULT_PORT INTOX_PORT
+#else
+#define ROBOT_DEFAULT_PORT 12345
+#endif
+
 /**
  * @typedef speed_pct_t
  * @brief Defines a type for speed percentage values.
@@ -22,6 +47,19 @@ typedef enum {
     BOTH_WHEEL    = 2    /**< Both wheels identifier */
 } wheel_t;
 
+/**
+ * @enum sensor_t
+ * @brief Proximity sensors, from left to right.
+ */
+typedef enum {
+    SENSOR_LEFT,          /**< Front left sensor */
+    SENSOR_CENTER_LEFT,   /**< Front center left sensor */
+    SENSOR_CENTER,        /**< Front center sensor */
+    SENSOR_CENTER_RIGHT,  /**< Front center right sensor */
+    SENSOR_RIGHT,         /**< Front right sensor */
+    SENSOR_NB             /**< Number of proximity sensors */
+} sensor_t;
+
 /**
  * @struct robot_status_t
  * @brief Structure to hold robot status information.
@@ -29,12 +67,46 @@ typedef enum {
 typedef struct {
     int left_encoder;   /**< Position of the left wheel encoder */
     int right_encoder;  /**< Position of the right wheel encoder */
-    int left_sensor;    /**< Value of the left proximity sensor */
-    int center_sensor;  /**< Value of the center proximity sensor */
-    int right_sensor;   /**< Value of the right proximity sensor */
+    int sensors[SENSOR_NB]; /**< Values of the proximity sensors (see sensor_t) */
     int battery;        /**< Battery level */
 } robot_status_t;
 
+/**
+ * @struct robot_snapshot_t
+ * @brief Status acquired once per control tick, shared by all consumers.
+ */
+typedef struct {
+    robot_status_t status;  /**< Cached encoder, sensor and battery values */
+    uint64_t timestamp_ns;  /**< Time of the acquisition on the robot clock (in nanoseconds, see clock.h) */
+    uint32_t seq;           /**< Acquisition sequence number (0 if never acquired) */
+    uint32_t encoder_resets; /**< Number of encoder resets (deltas across a change are meaningless) */
+} robot_snapshot_t;
+
+/**
+ * @struct robot_snapshot_stats_t
+ * @brief Counters about the status snapshot usage.
+ */
+typedef struct {
+    unsigned long acquisitions;       /**< Number of full acquisitions on the link */
+    unsigned long reads;              /**< Number of status reads served by the snapshot */
+    unsigned long link_calls;         /**< Number of mrpiz calls issued by the acquisitions */
+    unsigned long link_calls_avoided; /**< Number of mrpiz calls saved by the status reads counted in reads */
+} robot_snapshot_stats_t;
+
+/**
+ * @struct robot_command_stats_t
+ * @brief Counters about the actuator commands and the link calls they cost.
+ */
+typedef struct {
+    unsigned long speed_requests;   /**< Calls to robot_set_speed() */
+    unsigned long coalesced;        /**< Speed requests replaced by a later one of the same tick */
+    unsigned long immediate_stops;  /**< Stops sent at once, inside a tick */
+    unsigned long motor_calls;      /**< mrpiz_motor_set() calls issued */
+    unsigned long motor_calls_saved; /**< mrpiz_motor_set() calls avoided (2 per request without the cache) */
+    unsigned long led_requests;     /**< Calls to robot_signal_event() */
+    unsigned long led_calls_saved;  /**< mrpiz_led_rgb_set() calls avoided (same color) */
+} robot_command_stats_t;
+
 /**
  * @enum notification_t
  * @brief Enumeration of robot notification events.
@@ -49,6 +121,9 @@ typedef enum {
 /**
  * @brief Initializes and starts the robot.
  *
+ * The link goes to the simulator given by ROBOT_ADDRESS_ENV and
+ * ROBOT_PORT_ENV, or to the one set at compile time.
+ *
  * @return The initialization status.
  */
 int robot_start(void);
@@ -56,11 +131,51 @@ int robot_start(void);
 /**
  * @brief Sets the speed of the robot's wheels.
  *
+ * Only the wheels whose speed changed are sent on the link. Between
+ * robot_hold_commands() and robot_flush_commands() the speeds are only
+ * recorded, and the last ones are sent by the flush; a stop (both speeds
+ * 0) is always sent at once.
+ *
  * @param left Speed percentage for the left wheel.
  * @param right Speed percentage for the right wheel.
  */
 void robot_set_speed(speed_pct_t left, speed_pct_t right);
 
+/**
+ * @brief Holds the speed commands until robot_flush_commands().
+ *
+ * Called at the start of a control tick, so the commands of the tick
+ * cost at most one send.
+ */
+void robot_hold_commands(void);
+
+/**
+ * @brief Sends the speeds held since robot_hold_commands(), if they changed.
+ *
+ * Also sends again a speed whose last send failed.
+ */
+void robot_flush_commands(void);
+
+/**
+ * @brief Gets the actuator command counters.
+ *
+ * @return The counters since the start or the last reset.
+ */
+robot_command_stats_t robot_get_command_stats(void);
+
+/**
+ * @brief Resets the actuator command counters.
+ */
+void robot_reset_command_stats(void);
+
+/**
+ * @brief Gets the last speeds sent to the wheels.
+ *
+ * @param left Where to store the left wheel speed percentage.
+ * @param right Where to store the right wheel speed percentage.
+ */
+void robot_get_commanded_speed(speed_pct_t *left, speed_pct_t *right);
+
 /**
  * @brief Gets the position of a specific wheel.
  *
@@ -74,16 +189,50 @@ int robot_get_wheel_position(wheel_t wheel_id);
  */
 void robot_reset_wheel_pos(void);
 
+/**
+ * @brief Acquires the robot status from the link and stores it in the snapshot.
+ *
+ * Must be called once per control tick, before the consumers read the status.
+ */
+void robot_refresh_status(void);
+
 /**
  * @brief Gets the current status of the robot.
  *
+ * The status is read from the last snapshot without any link traffic.
+ * The first call acquires the status if no snapshot exists yet.
+ *
  * @return The status of the robot containing encoder, sensor, and battery information.
  */
 robot_status_t robot_get_status(void);
 
+/**
+ * @brief Gets the last snapshot with its timestamp and sequence number.
+ *
+ * Not counted in the snapshot usage counters: no status read it replaces
+ * went to the link before the snapshot.
+ *
+ * @return The last acquired snapshot.
+ */
+robot_snapshot_t robot_get_snapshot(void);
+
+/**
+ * @brief Gets the snapshot usage counters.
+ *
+ * @return The counters since the start or the last reset.
+ */
+robot_snapshot_stats_t robot_get_snapshot_stats(void);
+
+/**
+ * @brief Resets the snapshot usage counters.
+ */
+void robot_reset_snapshot_stats(void);
+
 /**
  * @brief Signals an event to external users.
  *
+ * The LED is only set on the link when its color changes.
+ *
  * @param event The event notification type.
  */
 void robot_signal_event(notification_t event);
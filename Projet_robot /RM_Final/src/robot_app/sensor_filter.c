@@ -0,0 +1,127 @@
+#include "sensor_filter.h"
+#include <math.h>
+#include <stdbool.h>
+#include <string.h>
+
+_Static_assert((SENSOR_FILTER_RANGE & (SENSOR_FILTER_RANGE - 1)) == 0, "the median search halves the range");
+_Static_assert(SENSOR_FILTER_MAX_WINDOW <= UINT16_MAX, "counts fit in a uint16_t");
+
+/** @brief Smallest gain of the smoothers, so their delay stays bounded. */
+#define MIN_GAIN 0.001
+
+/**
+ * Filters of one sensor.
+ */
+typedef struct {
+    int16_t ring[SENSOR_FILTER_MAX_WINDOW];    // Last readings, the oldest at head once full
+    int head;                                  // Next slot of the ring
+    int count;                                 // Number of readings in the ring
+    uint16_t tree[SENSOR_FILTER_RANGE + 1];    // Fenwick tree of the counts of each reading (from 1)
+    double estimate;                           // Output of the smoother
+    double variance;                           // Variance of the estimate (Kalman)
+    bool primed;                               // true once the smoother has an estimate
+} channel_t;
+
+static sensor_filter_config_t config = SENSOR_FILTER_DEFAULT_CONFIG;  // Settings of the filters
+static channel_t channels[SENSOR_NB];  // Filters of each sensor
+
+// Adds a count to a reading in the Fenwick tree
+static inline void tree_add(channel_t *channel, int value, int delta) {
+    for (int i = value + 1; i <= SENSOR_FILTER_RANGE; i += i & -i) {
+        channel->tree[i] = (uint16_t)(channel->tree[i] + delta);
+    }
+}
+
+// Finds the k-th smallest reading of the window (from 1) by halving the range
+static inline int tree_select(const channel_t *channel, int k) {
+    int position = 0;
+
+    for (int step = SENSOR_FILTER_RANGE; step > 0; step >>= 1) {
+        if (position + step <= SENSOR_FILTER_RANGE && channel->tree[position + step] < k) {
+            position += step;
+            k -= channel->tree[position];
+        }
+    }
+    return position;  // Fewer than k readings are below position
+}
+
+// Pushes a reading in the window and gives the median of the window
+static int running_median(channel_t *channel, int reading) {
+    int value = reading < 0 ? 0 : (reading >= SENSOR_FILTER_RANGE ? SENSOR_FILTER_RANGE - 1 : reading);
+
+    if (channel->count == config.window) {
+        tree_add(channel, channel->ring[channel->head], -1);  // Oldest reading leaves
+    } else {
+        channel->count++;
+    }
+    channel->ring[channel->head] = (int16_t)value;
+    channel->head = (channel->head + 1) % config.window;
+    tree_add(channel, value, 1);
+    return tree_select(channel, (channel->count + 1) / 2);
+}
+
+// Smooths the output of the median
+static double smooth(channel_t *channel, double median) {
+    if (!channel->primed || config.smoother == SMOOTHER_NONE) {
+        channel->estimate = median;
+        channel->variance = config.kalman_r;
+        channel->primed = true;
+        return median;
+    }
+    if (config.smoother == SMOOTHER_EMA) {
+        channel->estimate += config.ema_alpha * (median - channel->estimate);
+    } else {
+        // Constant reading model: predict, then correct with the gain
+        double predicted = channel->variance + config.kalman_q;
+        double gain = predicted / (predicted + config.kalman_r);
+        channel->estimate += gain * (median - channel->estimate);
+        channel->variance = (1.0 - gain) * predicted;
+    }
+    return channel->estimate;
+}
+
+// Changes the settings and forgets the past readings
+void sensor_filter_configure(const sensor_filter_config_t *new_config) {
+    config = *new_config;
+    config.window = config.window < 1 ? 1 : (config.window > SENSOR_FILTER_MAX_WINDOW ? SENSOR_FILTER_MAX_WINDOW : config.window);
+    config.ema_alpha = fmin(fmax(config.ema_alpha, MIN_GAIN), 1.0);
+    config.kalman_q = fmax(config.kalman_q, 0.0);
+    config.kalman_r = fmax(config.kalman_r, 0.0);
+    sensor_filter_reset();
+}
+
+// Gets the settings of the filters
+sensor_filter_config_t sensor_filter_get_config(void) {
+    return config;
+}
+
+// Forgets the past readings
+void sensor_filter_reset(void) {
+    memset(channels, 0, sizeof(channels));
+}
+
+// Filters one reading of each sensor
+void sensor_filter_update(const int raw[SENSOR_NB], int filtered[SENSOR_NB]) {
+    for (int i = 0; i < SENSOR_NB; i++) {
+        int median = running_median(&channels[i], raw[i]);
+        filtered[i] = (int)lround(smooth(&channels[i], median));
+    }
+}
+
+// Gets the delays added by the current settings
+sensor_filter_delay_t sensor_filter_get_delay(void) {
+    sensor_filter_delay_t delay = {(config.window - 1) / 2.0, 0.0, 0};
+    double gain = 1.0;
+
+    if (config.smoother == SMOOTHER_EMA) {
+        gain = config.ema_alpha;
+    } else if (config.smoother == SMOOTHER_KALMAN) {
+        // Settled gain: the predicted variance solves p^2 - q.p - q.r = 0
+        double q = config.kalman_q, r = config.kalman_r;
+        double predicted = (q + sqrt(q * q + 4.0 * q * r)) / 2.0;
+        gain = predicted + r > 0.0 ? fmax(predicted / (predicted + r), MIN_GAIN) : 1.0;
+    }
+    delay.smoother_samples = (1.0 - gain) / gain;
+    delay.total_ns = (uint64_t)llround((delay.median_samples + delay.smoother_samples) * (double)config.period_ns);
+    return delay;
+}
@@ -0,0 +1,102 @@
+#ifndef SENSOR_FILTER_H
+#define SENSOR_FILTER_H
+
+#include <stdint.h>
+#include "control_loop.h"
+#include "robot.h"
+
+/**
+ * @file sensor_filter.h
+ * @brief Filtering of the proximity readings, between the acquisition and the obstacle model.
+ *
+ * Each sensor goes through two stages, on every status acquisition:
+ * - a running median over a ring window of the last readings, which
+ *   removes isolated wrong samples (spikes, link errors read as -1);
+ *   the median is kept in a Fenwick tree of the counts of each reading,
+ *   so a sample costs O(log SENSOR_FILTER_RANGE) whatever the window;
+ * - a smoother (exponential or 1D Kalman) for the remaining noise.
+ *
+ * Both stages delay the readings: the median by (window - 1) / 2 samples,
+ * the smoother by (1 - gain) / gain samples. sensor_filter_get_delay()
+ * gives these delays, so a configuration can trade responsiveness
+ * against false detections. All the memory is static.
+ *
+ * The filters are updated by robot_refresh_status() only.
+ */
+
+/** @brief Number of possible readings (0 to SENSOR_FILTER_RANGE - 1, others are clamped). */
+#define SENSOR_FILTER_RANGE 256
+/** @brief Largest median window (in samples). */
+#define SENSOR_FILTER_MAX_WINDOW 31
+
+/**
+ * @enum sensor_smoother_t
+ * @brief Smoothers after the median.
+ */
+typedef enum {
+    SMOOTHER_NONE,    /**< Median only */
+    SMOOTHER_EMA,     /**< Exponential moving average of gain ema_alpha */
+    SMOOTHER_KALMAN   /**< 1D Kalman filter of a constant reading */
+} sensor_smoother_t;
+
+/**
+ * @struct sensor_filter_config_t
+ * @brief Settings of the filters.
+ */
+typedef struct {
+    int window;                  /**< Median window (1 to SENSOR_FILTER_MAX_WINDOW samples, 1 for no median) */
+    sensor_smoother_t smoother;  /**< Smoother after the median */
+    double ema_alpha;            /**< Gain of the exponential average (0 to 1, 1 for no smoothing) */
+    double kalman_q;             /**< Variance added to the reading at each sample (process noise) */
+    double kalman_r;             /**< Variance of the noise of a reading (measurement noise) */
+    uint64_t period_ns;          /**< Period of the acquisitions (in nanoseconds) */
+} sensor_filter_config_t;
+
+/** @brief Default settings, one acquisition per control tick: up to two wrong samples in a row are removed. */
+#define SENSOR_FILTER_DEFAULT_CONFIG {5, SMOOTHER_KALMAN, 0.5, 4.0, 16.0, CONTROL_PERIOD_NS}
+
+/**
+ * @struct sensor_filter_delay_t
+ * @brief Delays added by the filters.
+ */
+typedef struct {
+    double median_samples;    /**< Delay of the median (in samples) */
+    double smoother_samples;  /**< Delay of the smoother, once settled (in samples) */
+    uint64_t total_ns;        /**< Delay of both stages (in nanoseconds) */
+} sensor_filter_delay_t;
+
+/**
+ * @brief Changes the settings and forgets the past readings.
+ *
+ * @param config The new settings (the window is bounded to 1..SENSOR_FILTER_MAX_WINDOW).
+ */
+void sensor_filter_configure(const sensor_filter_config_t *config);
+
+/**
+ * @brief Gets the settings of the filters.
+ *
+ * @return The current settings.
+ */
+sensor_filter_config_t sensor_filter_get_config(void);
+
+/**
+ * @brief Forgets the past readings: the next sample starts the filters again.
+ */
+void sensor_filter_reset(void);
+
+/**
+ * @brief Filters one reading of each sensor.
+ *
+ * @param raw The readings just acquired, from left to right.
+ * @param filtered Where to store the filtered readings (may be raw).
+ */
+void sensor_filter_update(const int raw[SENSOR_NB], int filtered[SENSOR_NB]);
+
+/**
+ * @brief Gets the delays added by the current settings.
+ *
+ * @return The delays.
+ */
+sensor_filter_delay_t sensor_filter_get_delay(void);
+
+#endif // SENSOR_FILTER_H
@@ -0,0 +1,215 @@
+#include "speed_ctrl.h"
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "../utils.h"
+
+static speed_ctrl_gains_t gains = SPEED_CTRL_DEFAULT_GAINS;  // Controller gains
+static bool enabled = true;            // Closed loop switch
+static speed_pct_t target[2];          // Wheel speed targets (left, right)
+static speed_pct_t command[2];         // Last commands sent to the wheels
+static double lag_steps[2];            // Integral term: lag behind the expected position
+static double error_pct[2];            // Smoothed speed error
+static double heading_steps;           // Progress of the left wheel minus the right one
+static int last_encoder[2];            // Encoder values of the previous update
+static uint32_t last_resets;           // Encoder reset counter of the previous update
+static bool primed = false;            // true once last_encoder is valid
+
+static pthread_mutex_t stats_lock = PTHREAD_MUTEX_INITIALIZER; // Protects stats
+static speed_ctrl_stats_t stats;       // Tracking statistics
+static double error_sum;               // Sum of the absolute speed errors
+static double error_sq_sum;            // Sum of the squared speed errors
+
+// Sign of a speed target
+static int sign_of(speed_pct_t speed) {
+    return (speed > 0) - (speed < 0);
+}
+
+// Sends wheel commands, skipping the link when nothing changes
+static void send_command(speed_pct_t left, speed_pct_t right) {
+    if (left != command[0] || right != command[1]) {
+        command[0] = left;
+        command[1] = right;
+        robot_set_speed(left, right);
+    }
+}
+
+// Enables or disables the closed loop
+void speed_ctrl_set_enabled(bool on) {
+    enabled = on;
+}
+
+// Checks if the closed loop is enabled
+bool speed_ctrl_enabled(void) {
+    return enabled;
+}
+
+// Sets the gains of the controller
+void speed_ctrl_set_gains(const speed_ctrl_gains_t *new_gains) {
+    gains = *new_gains;
+}
+
+// Gets the gains of the controller
+speed_ctrl_gains_t speed_ctrl_get_gains(void) {
+    return gains;
+}
+
+// Sets the wheel speed targets and sends their feedforward
+void speed_ctrl_set_target(speed_pct_t left, speed_pct_t right) {
+    bool same_direction = sign_of(left) == sign_of(target[0]) && sign_of(right) == sign_of(target[1]);
+
+    if (enabled && same_direction && (left != 0 || right != 0)) {
+        // Speed change along the same motion (profile): keep correcting
+        target[0] = left;
+        target[1] = right;
+        if (!primed) {
+            send_command(left, right);  // Not measured yet: feedforward only
+        }
+        return;
+    }
+    target[0] = left;
+    target[1] = right;
+    lag_steps[0] = lag_steps[1] = 0.0;
+    error_pct[0] = error_pct[1] = 0.0;
+    heading_steps = 0.0;
+    primed = false;  // Measure from the next acquisition
+    command[0] = left;
+    command[1] = right;
+    robot_set_speed(left, right);
+}
+
+// Records the speed errors of one update
+static void record_errors(const double error[2], bool saturated) {
+    pthread_mutex_lock(&stats_lock);
+    stats.updates++;
+    if (saturated) {
+        stats.saturations++;
+    }
+    for (int w = 0; w < 2; w++) {
+        double abs_error = fabs(error[w]);
+        error_sum += abs_error;
+        error_sq_sum += error[w] * error[w];
+        if (abs_error > stats.max_abs_error) stats.max_abs_error = abs_error;
+    }
+    stats.mean_abs_error = error_sum / (2.0 * (double)stats.updates);
+    stats.rms_error = sqrt(error_sq_sum / (2.0 * (double)stats.updates));
+    if (abs((int)heading_steps) > stats.max_heading_error) {
+        stats.max_heading_error = abs((int)heading_steps);
+    }
+    pthread_mutex_unlock(&stats_lock);
+}
+
+// Corrects the wheel commands from the last snapshot
+void speed_ctrl_update(uint64_t period_ns) {
+    robot_snapshot_t snap = robot_get_snapshot();
+    int encoder[2] = {snap.status.left_encoder, snap.status.right_encoder};
+    double dt = (double)period_ns / (double)NS_PER_S;
+    double correction[2];
+    bool saturated = false;
+
+    if (!enabled || (target[0] == 0 && target[1] == 0) || period_ns == 0) {
+        primed = false;
+        return;
+    }
+    if (!primed || snap.encoder_resets != last_resets) {
+        // No previous value, or the encoders were reset since: start measuring now
+        last_encoder[0] = encoder[0];
+        last_encoder[1] = encoder[1];
+        last_resets = snap.encoder_resets;
+        primed = true;
+        return;
+    }
+
+    for (int w = 0; w < 2; w++) {
+        double expected = (double)target[w] / 100.0 * SPEED_CTRL_MAX_STEPS_PER_S * dt;
+        double moved = (double)(encoder[w] - last_encoder[w]);
+        double error = (expected - moved) / dt * 100.0 / SPEED_CTRL_MAX_STEPS_PER_S;
+
+        error_pct[w] += SPEED_CTRL_ERROR_ALPHA * (error - error_pct[w]);
+        lag_steps[w] += expected - moved;
+        lag_steps[w] = fmax(-SPEED_CTRL_MAX_LAG_STEPS, fmin(SPEED_CTRL_MAX_LAG_STEPS, lag_steps[w]));
+        correction[w] = gains.kp * error_pct[w]
+                      + gains.ki * lag_steps[w] * 100.0 / SPEED_CTRL_MAX_STEPS_PER_S;
+    }
+
+    // Heading hold: equal progress on both wheels when their speeds match
+    if (abs(target[0]) == abs(target[1])) {
+        heading_steps += sign_of(target[0]) * (encoder[0] - last_encoder[0])
+                       - sign_of(target[1]) * (encoder[1] - last_encoder[1]);
+        correction[0] -= sign_of(target[0]) * gains.k_heading * heading_steps;
+        correction[1] += sign_of(target[1]) * gains.k_heading * heading_steps;
+    }
+
+    speed_pct_t out[2];
+    for (int w = 0; w < 2; w++) {
+        double cmd;
+        if (correction[w] > gains.max_correction) {
+            correction[w] = gains.max_correction;
+            saturated = true;
+        } else if (correction[w] < -gains.max_correction) {
+            correction[w] = -gains.max_correction;
+            saturated = true;
+        }
+        cmd = (double)target[w] + correction[w];
+        if (cmd > 100.0) {
+            cmd = 100.0;
+            saturated = true;
+        } else if (cmd < -100.0) {
+            cmd = -100.0;
+            saturated = true;
+        }
+        out[w] = (speed_pct_t)lround(cmd);
+    }
+    if (saturated) {
+        // Anti-windup: do not let the lag grow while the command cannot follow
+        for (int w = 0; w < 2; w++) {
+            double expected = (double)target[w] / 100.0 * SPEED_CTRL_MAX_STEPS_PER_S * dt;
+            lag_steps[w] -= expected - (double)(encoder[w] - last_encoder[w]);
+        }
+    }
+
+    last_encoder[0] = encoder[0];
+    last_encoder[1] = encoder[1];
+    send_command(out[0], out[1]);
+    record_errors(error_pct, saturated);
+}
+
+// Forgets the targets and the controller state
+void speed_ctrl_reset(void) {
+    target[0] = target[1] = 0;
+    command[0] = command[1] = 0;
+    lag_steps[0] = lag_steps[1] = 0.0;
+    error_pct[0] = error_pct[1] = 0.0;
+    heading_steps = 0.0;
+    primed = false;
+}
+
+// Gets a copy of the tracking statistics
+speed_ctrl_stats_t speed_ctrl_get_stats(void) {
+    speed_ctrl_stats_t copy;
+    pthread_mutex_lock(&stats_lock);
+    copy = stats;
+    pthread_mutex_unlock(&stats_lock);
+    return copy;
+}
+
+// Clears the tracking statistics
+void speed_ctrl_reset_stats(void) {
+    pthread_mutex_lock(&stats_lock);
+    stats = (speed_ctrl_stats_t){0};
+    error_sum = 0.0;
+    error_sq_sum = 0.0;
+    pthread_mutex_unlock(&stats_lock);
+}
+
+// Prints the tracking statistics
+void speed_ctrl_print_stats(void) {
+    speed_ctrl_stats_t s = speed_ctrl_get_stats();
+    if (s.updates == 0) {
+        return;
+    }
+    printf("Asservissement vitesse : %lu mises à jour, %lu saturations\n", s.updates, s.saturations);
+    printf("  erreur vitesse moy/rms/max = %.1f/%.1f/%.1f %%, écart de cap max = %d pas\n",
+           s.mean_abs_error, s.rms_error, s.max_abs_error, s.max_heading_error);
+}
@@ -0,0 +1,128 @@
+#ifndef SPEED_CTRL_H
+#define SPEED_CTRL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "robot.h"
+
+/**
+ * @file speed_ctrl.h
+ * @brief Closed-loop wheel speed controller using the encoder feedback.
+ *
+ * The pilot gives wheel speed targets (in %) with speed_ctrl_set_target();
+ * the control tick then calls speed_ctrl_update() after the status
+ * acquisition. Each wheel has a PI controller around a feedforward of its
+ * target; the integral term is the lag of the wheel behind its expected
+ * position, so the quantization of the encoders does not accumulate. When
+ * both targets have the same magnitude (straight line or turn in place), a
+ * heading-hold term keeps the progress of the two wheels equal.
+ */
+
+/** @brief Wheel speed at a 100 % command (in encoder steps per second). */
+#define SPEED_CTRL_MAX_STEPS_PER_S 780.0
+/** @brief Largest lag kept by the integral term (in encoder steps), so a wheel never races to catch up. */
+#define SPEED_CTRL_MAX_LAG_STEPS 20.0
+/** @brief Smoothing factor of the measured speed error (0 < alpha <= 1). */
+#define SPEED_CTRL_ERROR_ALPHA 0.2
+
+/**
+ * @struct speed_ctrl_gains_t
+ * @brief Gains of the speed controller.
+ */
+typedef struct {
+    double kp;             /**< Proportional gain (% of command per % of speed error) */
+    double ki;             /**< Integral gain (% of command per %.s of speed error) */
+    double k_heading;      /**< Heading-hold gain (% of command per encoder step of imbalance) */
+    double max_correction; /**< Largest correction added to the feedforward (in %) */
+} speed_ctrl_gains_t;
+
+/** @brief Default gains, tuned on the native simulator at 200 Hz. */
+#define SPEED_CTRL_DEFAULT_GAINS {0.8, 4.0, 0.3, 20.0}
+
+/**
+ * @struct speed_ctrl_stats_t
+ * @brief Tracking statistics of the speed controller.
+ */
+typedef struct {
+    unsigned long updates;     /**< Number of closed-loop updates */
+    unsigned long saturations; /**< Number of updates where a command was clamped */
+    double mean_abs_error;     /**< Mean absolute speed error of the wheels (in %) */
+    double rms_error;          /**< Root mean square speed error of the wheels (in %) */
+    double max_abs_error;      /**< Largest absolute speed error (in %) */
+    int max_heading_error;     /**< Largest progress difference between the wheels (in encoder steps) */
+} speed_ctrl_stats_t;
+
+/**
+ * @brief Enables or disables the closed loop (enabled by default).
+ *
+ * When disabled, the targets are sent as they are to the wheels.
+ *
+ * @param enabled true to correct the wheel speeds.
+ */
+void speed_ctrl_set_enabled(bool enabled);
+
+/**
+ * @brief Checks if the closed loop is enabled.
+ *
+ * @return true if enabled.
+ */
+bool speed_ctrl_enabled(void);
+
+/**
+ * @brief Sets the gains of the controller.
+ *
+ * @param gains The new gains.
+ */
+void speed_ctrl_set_gains(const speed_ctrl_gains_t *gains);
+
+/**
+ * @brief Gets the gains of the controller.
+ *
+ * @return The current gains.
+ */
+speed_ctrl_gains_t speed_ctrl_get_gains(void);
+
+/**
+ * @brief Sets the wheel speed targets and sends their feedforward at once.
+ *
+ * The integral and heading terms restart from zero when a wheel changes
+ * direction (or starts or stops); a speed change in the same direction,
+ * as given by a motion profile on every tick, keeps them.
+ *
+ * @param left Speed percentage wanted for the left wheel.
+ * @param right Speed percentage wanted for the right wheel.
+ */
+void speed_ctrl_set_target(speed_pct_t left, speed_pct_t right);
+
+/**
+ * @brief Corrects the wheel commands from the last snapshot.
+ *
+ * Must be called once per control tick, after robot_refresh_status().
+ *
+ * @param period_ns The control tick period (in nanoseconds).
+ */
+void speed_ctrl_update(uint64_t period_ns);
+
+/**
+ * @brief Forgets the targets and the controller state (the wheels are not commanded).
+ */
+void speed_ctrl_reset(void);
+
+/**
+ * @brief Gets the tracking statistics.
+ *
+ * @return The statistics since the start or the last reset.
+ */
+speed_ctrl_stats_t speed_ctrl_get_stats(void);
+
+/**
+ * @brief Clears the tracking statistics.
+ */
+void speed_ctrl_reset_stats(void);
+
+/**
+ * @brief Prints the tracking statistics.
+ */
+void speed_ctrl_print_stats(void);
+
+#endif // SPEED_CTRL_H
@@ -0,0 +1,78 @@
+#include "telemetry.h"
+#include <stdalign.h>
+#include <stdatomic.h>
+
+#define TELEMETRY_MASK (TELEMETRY_CAPACITY - 1)
+
+_Static_assert((TELEMETRY_CAPACITY & TELEMETRY_MASK) == 0, "TELEMETRY_CAPACITY must be a power of 2");
+
+/**
+ * The ring: the producer and the consumer each own one cache line
+ * (their index plus a cached copy of the other side's index), so they
+ * only share a line when the cached copy runs out.
+ */
+static struct {
+    alignas(TELEMETRY_CACHE_LINE) atomic_uint_fast32_t head;  // Next slot to write (producer)
+    uint_fast32_t cached_tail;                                // Producer copy of tail
+    unsigned long overflows;                                  // Records dropped (producer)
+
+    alignas(TELEMETRY_CACHE_LINE) atomic_uint_fast32_t tail;  // Next slot to read (consumer)
+    uint_fast32_t cached_head;                                // Consumer copy of head
+
+    alignas(TELEMETRY_CACHE_LINE) telemetry_record_t slots[TELEMETRY_CAPACITY];
+} ring;
+
+// Publishes a record without waiting (producer side)
+bool telemetry_publish(const telemetry_record_t *record) {
+    uint_fast32_t head = atomic_load_explicit(&ring.head, memory_order_relaxed);
+
+    if (head - ring.cached_tail >= TELEMETRY_CAPACITY) {
+        ring.cached_tail = atomic_load_explicit(&ring.tail, memory_order_acquire);
+        if (head - ring.cached_tail >= TELEMETRY_CAPACITY) {
+            // Full: drop the record rather than wait
+            __atomic_store_n(&ring.overflows, ring.overflows + 1, __ATOMIC_RELAXED);
+            return false;
+        }
+    }
+    ring.slots[head & TELEMETRY_MASK] = *record;
+    atomic_store_explicit(&ring.head, head + 1, memory_order_release);
+    return true;
+}
+
+// Takes the oldest record out of the ring (consumer side)
+bool telemetry_consume(telemetry_record_t *record) {
+    uint_fast32_t tail = atomic_load_explicit(&ring.tail, memory_order_relaxed);
+
+    if (tail == ring.cached_head) {
+        ring.cached_head = atomic_load_explicit(&ring.head, memory_order_acquire);
+        if (tail == ring.cached_head) {
+            return false;  // Empty
+        }
+    }
+    *record = ring.slots[tail & TELEMETRY_MASK];
+    atomic_store_explicit(&ring.tail, tail + 1, memory_order_release);
+    return true;
+}
+
+// Drains the ring and keeps the newest record
+unsigned int telemetry_drain_latest(telemetry_record_t *latest) {
+    unsigned int count = 0;
+    while (telemetry_consume(latest)) {
+        count++;
+    }
+    return count;
+}
+
+// Gets the number of dropped records
+unsigned long telemetry_get_overflows(void) {
+    return __atomic_load_n(&ring.overflows, __ATOMIC_RELAXED);
+}
+
+// Empties the ring and clears the overflow counter
+void telemetry_reset(void) {
+    atomic_store(&ring.head, 0);
+    atomic_store(&ring.tail, 0);
+    ring.cached_tail = 0;
+    ring.cached_head = 0;
+    ring.overflows = 0;
+}
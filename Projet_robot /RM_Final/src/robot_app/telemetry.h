@@ -0,0 +1,76 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "robot.h"
+#include "pilot.h"
+#include "copilot.h"
+#include "odometry.h"
+
+/**
+ * @file telemetry.h
+ * @brief Lock-free single-producer/single-consumer telemetry ring.
+ *
+ * The control thread publishes one record per tick without ever waiting;
+ * the UI (or a logger) drains the records at its own pace. When the ring
+ * is full the new record is dropped and counted as an overflow.
+ */
+
+/** @brief Number of records in the ring (must be a power of 2). */
+#define TELEMETRY_CAPACITY 256
+/** @brief Size of a cache line, used to keep producer and consumer data apart. */
+#define TELEMETRY_CACHE_LINE 64
+
+/**
+ * @struct telemetry_record_t
+ * @brief State of the control loop at one tick.
+ */
+typedef struct {
+    robot_snapshot_t snapshot;  /**< Status acquired for the tick */
+    odometry_pose_t pose;       /**< Pose estimated at the tick */
+    move_status_t move_status;  /**< Pilot movement status */
+    path_status_t path_status;  /**< Copilot path status */
+    int step;                   /**< Current step index in the path */
+    uint64_t publish_ns;        /**< Monotonic time of the publication */
+} telemetry_record_t;
+
+/**
+ * @brief Publishes a record (producer side, never waits).
+ *
+ * @param record The record to copy into the ring.
+ * @return true if published, false if the ring was full (overflow counted).
+ */
+bool telemetry_publish(const telemetry_record_t *record);
+
+/**
+ * @brief Takes the oldest record out of the ring (consumer side).
+ *
+ * @param record Where to copy the record.
+ * @return true if a record was read, false if the ring was empty.
+ */
+bool telemetry_consume(telemetry_record_t *record);
+
+/**
+ * @brief Takes all the pending records out of the ring and keeps the newest one.
+ *
+ * @param latest Where to copy the newest record.
+ * @return The number of records drained (0 if the ring was empty).
+ */
+unsigned int telemetry_drain_latest(telemetry_record_t *latest);
+
+/**
+ * @brief Gets the number of records dropped because the ring was full.
+ *
+ * @return The overflow counter.
+ */
+unsigned long telemetry_get_overflows(void);
+
+/**
+ * @brief Empties the ring and clears the overflow counter.
+ *
+ * Must not be called while a producer or a consumer is active.
+ */
+void telemetry_reset(void);
+
+#endif // TELEMETRY_H
@@ -0,0 +1,148 @@
+#include "telemetry_shm.h"
+#include <fcntl.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+static telemetry_shm_segment_t *segment;  // Segment of the writer (NULL if not open)
+static char segment_name[64];             // Name to remove at the closing
+static uint64_t publications;             // States published since the opening
+
+// Gets the name of the segment used when none is given
+const char *telemetry_shm_default_name(void) {
+    const char *name = getenv(TELEMETRY_SHM_ENV);
+    return name != NULL && name[0] != '\0' ? name : TELEMETRY_SHM_DEFAULT_NAME;
+}
+
+// Creates the segment and maps it for writing
+int telemetry_shm_open(const char *name) {
+    int fd;
+
+    if (segment != NULL) {
+        return 0;
+    }
+    if (name == NULL) {
+        name = telemetry_shm_default_name();
+    }
+    if (strlen(name) >= sizeof(segment_name)) {
+        return -1;
+    }
+    fd = shm_open(name, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        return -1;
+    }
+    if (ftruncate(fd, sizeof(telemetry_shm_segment_t)) != 0) {
+        close(fd);
+        shm_unlink(name);
+        return -1;
+    }
+    segment = mmap(NULL, sizeof(telemetry_shm_segment_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (segment == MAP_FAILED) {
+        segment = NULL;
+        shm_unlink(name);
+        return -1;
+    }
+    strcpy(segment_name, name);
+    publications = 0;
+
+    // The header last, so a reader never trusts a half-initialized segment
+    segment->version = TELEMETRY_SHM_VERSION;
+    segment->state_size = sizeof(telemetry_shm_state_t);
+    segment->pid = getpid();
+    atomic_store_explicit(&segment->seq, 0, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    segment->magic = TELEMETRY_SHM_MAGIC;
+    return 0;
+}
+
+// Publishes a state, never waiting for the readers
+void telemetry_shm_publish(const telemetry_shm_state_t *state) {
+    if (segment == NULL) {
+        return;
+    }
+    unsigned int seq = atomic_load_explicit(&segment->seq, memory_order_relaxed);
+
+    atomic_store_explicit(&segment->seq, seq + 1, memory_order_relaxed);  // Odd: being written
+    atomic_thread_fence(memory_order_release);
+    memcpy(&segment->state, state, sizeof(*state));
+    segment->state.publications = ++publications;
+    atomic_store_explicit(&segment->seq, seq + 2, memory_order_release);
+}
+
+// Counts the end of a mission in the segment
+void telemetry_shm_count_mission(bool completed) {
+    if (segment == NULL) {
+        return;
+    }
+    atomic_fetch_add_explicit(completed ? &segment->missions_completed : &segment->missions_failed,
+                              1, memory_order_relaxed);
+}
+
+// Unmaps and removes the segment
+void telemetry_shm_close(void) {
+    if (segment == NULL) {
+        return;
+    }
+    munmap(segment, sizeof(telemetry_shm_segment_t));
+    segment = NULL;
+    shm_unlink(segment_name);
+}
+
+// Maps an existing segment for reading
+const telemetry_shm_segment_t *telemetry_shm_attach(const char *name) {
+    telemetry_shm_segment_t *mapped;
+    int fd = shm_open(name != NULL ? name : telemetry_shm_default_name(), O_RDONLY, 0);
+
+    if (fd < 0) {
+        return NULL;
+    }
+    mapped = mmap(NULL, sizeof(telemetry_shm_segment_t), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        return NULL;
+    }
+    if (mapped->magic != TELEMETRY_SHM_MAGIC || mapped->version != TELEMETRY_SHM_VERSION ||
+        mapped->state_size != sizeof(telemetry_shm_state_t)) {
+        munmap(mapped, sizeof(telemetry_shm_segment_t));
+        return NULL;  // Another layout, or not initialized yet
+    }
+    atomic_thread_fence(memory_order_acquire);
+    return mapped;
+}
+
+// Unmaps a segment mapped by telemetry_shm_attach()
+void telemetry_shm_detach(const telemetry_shm_segment_t *mapped) {
+    munmap((void *)mapped, sizeof(telemetry_shm_segment_t));
+}
+
+// Gets the mission counters of a segment
+void telemetry_shm_get_missions(const telemetry_shm_segment_t *mapped, unsigned int *completed, unsigned int *failed) {
+    // Only read: the segment is mapped read-only
+    telemetry_shm_segment_t *counters = (telemetry_shm_segment_t *)mapped;
+
+    *completed = atomic_load_explicit(&counters->missions_completed, memory_order_relaxed);
+    *failed = atomic_load_explicit(&counters->missions_failed, memory_order_relaxed);
+}
+
+// Copies a consistent state out of a segment
+bool telemetry_shm_read(const telemetry_shm_segment_t *mapped, telemetry_shm_state_t *state) {
+    // The sequence is only read: the segment is mapped read-only
+    atomic_uint *seq = (atomic_uint *)&mapped->seq;
+
+    for (int i = 0; i < TELEMETRY_SHM_READ_TRIES; i++) {
+        unsigned int before = atomic_load_explicit(seq, memory_order_acquire);
+        if (before & 1u) {
+            sched_yield();  // The writer is copying
+            continue;
+        }
+        memcpy(state, &mapped->state, sizeof(*state));
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(seq, memory_order_relaxed) == before) {
+            return true;
+        }
+    }
+    return false;
+}
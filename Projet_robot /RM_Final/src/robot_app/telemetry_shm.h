@@ -0,0 +1,137 @@
+#ifndef TELEMETRY_SHM_H
+#define TELEMETRY_SHM_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include "telemetry.h"
+#include "control_loop.h"
+
+/**
+ * @file telemetry_shm.h
+ * @brief Live state of the control loop, exported in a POSIX shared memory segment.
+ *
+ * The control thread writes the state of each tick in the segment, and
+ * any number of local processes (see tools/robot_watch.c) read it at
+ * their own rate, without the controller knowing about them.
+ *
+ * The segment is guarded by a seqlock: the writer makes the sequence odd,
+ * copies the state and makes it even again, never waiting for anyone. A
+ * reader copies the state between two reads of the sequence, and tries
+ * again if the sequence was odd or has changed.
+ *
+ * The mission counters of the header are written outside of the ticks,
+ * by the thread running the missions (see fleet.h), and read atomically.
+ */
+
+/** @brief Segment written by default. */
+#define TELEMETRY_SHM_DEFAULT_NAME "/mrpiz_telemetry"
+/** @brief Environment variable giving another segment name. */
+#define TELEMETRY_SHM_ENV "MRPIZ_TELEMETRY_SHM"
+/** @brief Magic number of the segment ("MRPT"). */
+#define TELEMETRY_SHM_MAGIC 0x5450524Du
+/** @brief Layout version of the segment. */
+#define TELEMETRY_SHM_VERSION 2
+/** @brief Tries of a reader before giving up on a busy writer. */
+#define TELEMETRY_SHM_READ_TRIES 100
+
+/**
+ * @struct telemetry_shm_state_t
+ * @brief State published at each tick.
+ */
+typedef struct {
+    telemetry_record_t record;  /**< Status, pose, move and path state of the tick */
+    speed_pct_t left_speed;     /**< Last speed sent to the left wheel */
+    speed_pct_t right_speed;    /**< Last speed sent to the right wheel */
+    control_loop_stats_t loop;  /**< Timing statistics of the control loop */
+    uint64_t publications;      /**< Number of states published since the opening (set by telemetry_shm_publish()) */
+} telemetry_shm_state_t;
+
+/**
+ * @struct telemetry_shm_segment_t
+ * @brief Layout of the shared memory segment.
+ */
+typedef struct {
+    uint32_t magic;              /**< TELEMETRY_SHM_MAGIC */
+    uint32_t version;            /**< TELEMETRY_SHM_VERSION */
+    uint32_t state_size;         /**< sizeof(telemetry_shm_state_t) */
+    pid_t pid;                   /**< Process of the writer */
+    atomic_uint seq;             /**< Seqlock sequence, odd while the writer copies (32 bits: lock-free on the Pi Zero) */
+    atomic_uint missions_completed; /**< Missions ended at their last step */
+    atomic_uint missions_failed;    /**< Missions given up (timeout or path unavailable) */
+    telemetry_shm_state_t state; /**< Last published state */
+} telemetry_shm_segment_t;
+
+/**
+ * @brief Creates the segment and maps it for writing.
+ *
+ * @param name Name of the segment (NULL for TELEMETRY_SHM_ENV or TELEMETRY_SHM_DEFAULT_NAME).
+ * @return 0 on success, -1 on failure.
+ */
+int telemetry_shm_open(const char *name);
+
+/**
+ * @brief Publishes a state (writer side, never waits).
+ *
+ * Does nothing if the segment is not open.
+ *
+ * @param state The state to copy into the segment.
+ */
+void telemetry_shm_publish(const telemetry_shm_state_t *state);
+
+/**
+ * @brief Counts the end of a mission in the segment.
+ *
+ * Does nothing if the segment is not open.
+ *
+ * @param completed true if the mission reached its last step, false if it was given up.
+ */
+void telemetry_shm_count_mission(bool completed);
+
+/**
+ * @brief Unmaps and removes the segment.
+ */
+void telemetry_shm_close(void);
+
+/**
+ * @brief Maps an existing segment for reading.
+ *
+ * @param name Name of the segment (NULL for TELEMETRY_SHM_ENV or TELEMETRY_SHM_DEFAULT_NAME).
+ * @return The segment, NULL if it does not exist or has another layout.
+ */
+const telemetry_shm_segment_t *telemetry_shm_attach(const char *name);
+
+/**
+ * @brief Unmaps a segment mapped by telemetry_shm_attach().
+ *
+ * @param segment The segment.
+ */
+void telemetry_shm_detach(const telemetry_shm_segment_t *segment);
+
+/**
+ * @brief Copies a consistent state out of a segment (reader side).
+ *
+ * @param segment The segment.
+ * @param state Where to copy the state.
+ * @return true if a consistent state was copied, false if the writer stayed busy.
+ */
+bool telemetry_shm_read(const telemetry_shm_segment_t *segment, telemetry_shm_state_t *state);
+
+/**
+ * @brief Gets the mission counters of a segment (reader side).
+ *
+ * @param segment The segment.
+ * @param completed Where to store the number of completed missions.
+ * @param failed Where to store the number of missions given up.
+ */
+void telemetry_shm_get_missions(const telemetry_shm_segment_t *segment, unsigned int *completed, unsigned int *failed);
+
+/**
+ * @brief Gets the name of the segment used when none is given.
+ *
+ * @return TELEMETRY_SHM_ENV if set, TELEMETRY_SHM_DEFAULT_NAME otherwise.
+ */
+const char *telemetry_shm_default_name(void);
+
+#endif // TELEMETRY_SHM_H
@@ -0,0 +1,63 @@
+/**
+ * @file flight_dump.c
+ * @brief Converts a flight recorder file to CSV, oldest record first.
+ *
+ * Usage : flight_dump [recording] > run.csv
+ */
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "../robot_app/flight_recorder.h"
+
+int main(int argc, char *argv[]) {
+    const char *path = argc > 1 ? argv[1] : FLIGHT_RECORDER_DEFAULT_PATH;
+    struct stat st;
+    int fd;
+
+    fd = open(path, O_RDONLY);
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        perror(path);
+        return EXIT_FAILURE;
+    }
+    if ((size_t)st.st_size < sizeof(flight_header_t)) {
+        fprintf(stderr, "%s : fichier trop court\n", path);
+        close(fd);
+        return EXIT_FAILURE;
+    }
+    const flight_header_t *header = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (header == MAP_FAILED) {
+        perror(path);
+        return EXIT_FAILURE;
+    }
+
+    // Validate the header before trusting the sizes it gives
+    if (header->magic != FLIGHT_RECORDER_MAGIC || header->version != FLIGHT_RECORDER_VERSION ||
+        header->record_size != sizeof(flight_record_t) || header->capacity == 0 ||
+        (size_t)st.st_size < sizeof(flight_header_t) + (size_t)header->capacity * sizeof(flight_record_t)) {
+        fprintf(stderr, "%s : enregistrement invalide ou de version différente\n", path);
+        return EXIT_FAILURE;
+    }
+
+    const flight_record_t *records = (const flight_record_t *)(header + 1);
+    uint64_t written = header->written;
+    uint64_t first = written > header->capacity ? written - header->capacity : 0;
+
+    printf("time_s,seq,left_encoder,right_encoder,left_sensor,center_left_sensor,center_sensor,"
+           "center_right_sensor,right_sensor,"
+           "battery,left_speed,right_speed,step,move_status,path_status\n");
+    for (uint64_t i = first; i < written; i++) {
+        const flight_record_t *r = &records[i % header->capacity];
+        double time_s = (double)(int64_t)(r->timestamp_ns - header->start_ns) / 1e9;
+        printf("%.6f,%u,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%u,%u\n",
+               time_s, (unsigned)r->seq, (int)r->left_encoder, (int)r->right_encoder,
+               r->sensors[SENSOR_LEFT], r->sensors[SENSOR_CENTER_LEFT], r->sensors[SENSOR_CENTER],
+               r->sensors[SENSOR_CENTER_RIGHT], r->sensors[SENSOR_RIGHT], r->battery,
+               r->left_speed, r->right_speed, r->step, r->move_status, r->path_status);
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,31 @@
+/**
+ * @file mission_compile.c
+ * @brief Validates a mission and writes it in the binary form.
+ *
+ * Usage : mission_compile mission.txt mission.bin
+ *
+ * The binary mission is loaded by the robot without any parsing: compile it
+ * for the robot (same byte order) when the mission is long.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "../robot_app/mission.h"
+
+int main(int argc, char *argv[]) {
+    mission_t mission;
+
+    if (argc != 3) {
+        fprintf(stderr, "Usage : %s mission.txt mission.bin\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    if (mission_load(argv[1], &mission) != 0) {
+        return EXIT_FAILURE;
+    }
+    int result = mission_save(argv[2], mission.path.moves, mission.path.steps);
+    if (result == 0) {
+        printf("%s : %d mouvements\n", argv[2], mission.path.steps);
+    }
+    mission_unload(&mission);
+    return result == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
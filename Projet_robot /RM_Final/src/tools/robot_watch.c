@@ -0,0 +1,110 @@
+/**
+ * @file robot_watch.c
+ * @brief Prints the live state of a running robot, read in its shared memory segment.
+ *
+ * Usage : robot_watch [-n segment] [-i interval_ms] [-1]
+ *
+ * One line per interval (200 ms by default), or a single one with -1.
+ * The controller is never slowed down: the state is copied out of the
+ * segment under its seqlock, whatever the number of readers.
+ */
+
+#include <errno.h>
+#include <math.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include "../robot_app/telemetry_shm.h"
+#include "../utils.h"
+
+/** @brief Default interval between two lines (in milliseconds). */
+#define WATCH_DEFAULT_INTERVAL_MS 200
+
+// Prints one line of the live state
+static void print_state(const telemetry_shm_segment_t *segment, const telemetry_shm_state_t *state) {
+    const telemetry_record_t *r = &state->record;
+    const int *sensors = r->snapshot.status.sensors;
+    uint64_t now = monotonic_ns();
+    double age_ms = now > r->publish_ns ? (double)(now - r->publish_ns) / 1e6 : 0.0;
+    unsigned int completed, failed;
+
+    telemetry_shm_get_missions(segment, &completed, &failed);
+
+    printf("tick %u | x %.0f y %.0f mm cap %.1f deg v %.0f mm/s | étape %d mouvement %d chemin %d | "
+           "roues %d/%d | capteurs %d %d %d %d %d | batterie %d%% | "
+           "boucle %lu ticks %lu dépassements gigue %llu/%llu us tick max %llu us | missions %u/%u | âge %.1f ms\n",
+           (unsigned)r->snapshot.seq, r->pose.x_mm, r->pose.y_mm, r->pose.theta_rad * 180.0 / M_PI, r->pose.v_mm_s,
+           r->step, r->move_status, r->path_status, state->left_speed, state->right_speed,
+           sensors[SENSOR_LEFT], sensors[SENSOR_CENTER_LEFT], sensors[SENSOR_CENTER],
+           sensors[SENSOR_CENTER_RIGHT], sensors[SENSOR_RIGHT], r->snapshot.status.battery,
+           state->loop.ticks, state->loop.overruns,
+           (unsigned long long)(state->loop.mean_jitter_ns / 1000), (unsigned long long)(state->loop.max_jitter_ns / 1000),
+           (unsigned long long)(state->loop.max_tick_ns / 1000), completed, completed + failed, age_ms);
+    fflush(stdout);
+}
+
+int main(int argc, char *argv[]) {
+    const char *name = NULL;
+    long interval_ms = WATCH_DEFAULT_INTERVAL_MS;
+    bool once = false;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:i:1")) != -1) {
+        switch (opt) {
+            case 'n':
+                name = optarg;
+                break;
+            case 'i':
+                interval_ms = strtol(optarg, NULL, 10);
+                break;
+            case '1':
+                once = true;
+                break;
+            default:
+                fprintf(stderr, "Usage : %s [-n segment] [-i interval_ms] [-1]\n", argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+    if (interval_ms <= 0) {
+        interval_ms = WATCH_DEFAULT_INTERVAL_MS;
+    }
+    if (name == NULL) {
+        name = telemetry_shm_default_name();
+    }
+
+    const telemetry_shm_segment_t *segment = telemetry_shm_attach(name);
+    if (segment == NULL) {
+        fprintf(stderr, "%s : aucun robot en cours d'exécution (ou version différente)\n", name);
+        return EXIT_FAILURE;
+    }
+
+    struct timespec interval = {interval_ms / 1000, (interval_ms % 1000) * 1000000L};
+    telemetry_shm_state_t state;
+    int result = EXIT_SUCCESS;
+
+    for (;;) {
+        // The segment outlives a killed controller: check that it still runs
+        if (kill(segment->pid, 0) != 0 && errno == ESRCH) {
+            fprintf(stderr, "%s : contrôleur %d arrêté\n", name, (int)segment->pid);
+            result = EXIT_FAILURE;
+            break;
+        }
+        if (!telemetry_shm_read(segment, &state)) {
+            fprintf(stderr, "%s : état illisible (écrivain occupé)\n", name);
+        } else if (state.publications == 0) {
+            printf("%s : en attente de la boucle de contrôle\n", name);
+            fflush(stdout);
+        } else {
+            print_state(segment, &state);
+        }
+        if (once) {
+            break;
+        }
+        nanosleep(&interval, NULL);
+    }
+    telemetry_shm_detach(segment);
+    return result;
+}
@@ -1,20 +1,22 @@
 #ifndef UTILS_H
 #define UTILS_H
 
+#include <stdint.h>
 #include <stdio.h>
+#include <time.h>
 
-#ifdef NDEBUG // release mode
-#define TRACE(fmt, ...)
+/** @brief Number of nanoseconds in one second. */
+#define NS_PER_S 1000000000ULL
 
-#else // debug mode
-/// @warning : use gcc idiom for variable arguments (works even if no variable
-/// argument are added)
-#define TRACE(fmt, ...)                                                        \
-  do {                                                                         \
-    fprintf(stderr, "%s:%d:%s(): " fmt, __FILE__, __LINE__, __func__,          \
-            ##__VA_ARGS__);                                                    \
-    fflush(stderr);                                                            \
-  } while (0);
-#endif // NDEBUG
+/**
+ * @brief Gets the monotonic time.
+ *
+ * @return CLOCK_MONOTONIC time in nanoseconds.
+ */
+static inline uint64_t monotonic_ns(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t)now.tv_sec * NS_PER_S + (uint64_t)now.tv_nsec;
+}
 
 #endif // UTILS_H